@@ -0,0 +1,80 @@
+// ZaWarudo Headers
+#include "cache.hpp"
+
+// Utility Headers
+#include "serialize.hpp"
+
+// C++ STL
+#include <cstdio>
+#include <iomanip>
+#include <sstream>
+
+const std::uint32_t zw::cache::version;
+
+zw::cache::cache( const std::string &directory )
+	: directory_( directory ), hash_( 14695981039346656037ull )
+{
+	key( version );
+}
+
+void zw::cache::key( const std::string &value )
+{
+	key( value.size() );
+	mix( reinterpret_cast<const unsigned char *>( value.data() ), value.size() );
+}
+
+std::string zw::cache::file() const
+{
+	std::stringstream name;
+	name << directory_ << "/" << std::hex << std::setw( 16 ) << std::setfill( '0' )
+	     << hash_ << ".layer";
+	return name.str();
+}
+
+bool zw::cache::load( std::vector<double> &layer ) const
+{
+	serialize::input handle( file() );
+	
+	if ( !handle.exists() || handle.read<std::uint32_t>() != version
+	        || handle.read<std::uint64_t>() != hash_
+	        || handle.read<cell_size_t>() != layer.size() )
+		return false;
+		
+	handle.read( layer.data(), layer.size() );
+	return handle.exists();
+}
+
+bool zw::cache::save( const std::vector<double> &layer ) const
+{
+	// Written under a temporary name and moved into place, so a run that
+	// stops halfway or races another never leaves a partial layer behind.
+	
+	std::string name = file();
+	std::string partial = name + ".partial";
+	serialize::output handle( partial );
+	
+	handle.write( version );
+	handle.write( hash_ );
+	handle.write( cell_size_t( layer.size() ) );
+	handle.write( layer.data(), layer.size() );
+	
+	bool written = handle.exists();
+	handle.close();
+	
+	if ( !written || std::rename( partial.c_str(), name.c_str() ) != 0 )
+	{
+		std::remove( partial.c_str() );
+		return false;
+	}
+	
+	return true;
+}
+
+void zw::cache::mix( const unsigned char *bytes, const std::size_t size )
+{
+	// FNV-1a
+	
+	for ( std::size_t i = 0; i < size; ++i )
+		hash_ = ( hash_ ^ bytes[i] ) * 1099511628211ull;
+}
+
@@ -0,0 +1,57 @@
+#ifndef CACHE_HPP
+#define CACHE_HPP
+
+// ZaWarudo Headers
+#include "config.hpp"
+
+// C++ STL
+#include <cstdint>
+#include <string>
+#include <vector>
+
+namespace zw
+{
+	//
+	// Directory of per-cell layers, each named after a hash of everything
+	// that went into it, so a layer is reused whenever the same inputs come
+	// up again. The version is part of every key; bump it whenever the code
+	// producing a layer changes its output.
+	//
+	class cache
+	{
+	public:
+	
+		// Constructors
+		
+		explicit cache( const std::string &directory );
+		
+		// Functions
+		
+		static const std::uint32_t version = 1;
+		
+		// Adds an input to the key. Inputs must all be added before the
+		// layer is loaded or saved.
+		template<typename T>
+		void key( const T &value )
+		{
+			mix( reinterpret_cast<const unsigned char *>( &value ), sizeof( T ) );
+		}
+		
+		void key( const std::string &value );
+		
+		std::string file() const;
+		
+		// Fills a layer already sized to the grid.
+		bool load( std::vector<double> &layer ) const;
+		bool save( const std::vector<double> &layer ) const;
+		
+	private:
+		void mix( const unsigned char *bytes, const std::size_t size );
+		
+		std::string directory_;
+		std::uint64_t hash_;
+	};
+}
+
+#endif
+
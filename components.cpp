@@ -0,0 +1,159 @@
+// ZaWarudo Headers
+#include "components.hpp"
+
+// C++ STL
+#include <algorithm>
+#include <functional>
+
+//
+// Internal Stuff
+//
+
+namespace
+{
+	using zw::cell_size_t;
+	
+	// Union-find with path halving and union by size.
+	struct disjoint
+	{
+		explicit disjoint( const cell_size_t count ) : parent( count ), size( count, 1 )
+		{
+			for ( cell_size_t c = 0; c < count; ++c )
+				parent[c] = c;
+		}
+		
+		cell_size_t find( cell_size_t c )
+		{
+			while ( parent[c] != c )
+				c = parent[c] = parent[parent[c]];
+				
+			return c;
+		}
+		
+		cell_size_t join( cell_size_t a, cell_size_t b )
+		{
+			if ( size[a] < size[b] )
+				std::swap( a, b );
+				
+			parent[b] = a;
+			size[a] += size[b];
+			return a;
+		}
+		
+		std::vector<cell_size_t> parent, size;
+	};
+}
+
+//
+// Public API
+//
+
+const zw::cell_size_t zw::components::none;
+
+zw::components::components( const geoData::geo_ptr &data,
+                            const ranking &index, const bool descending )
+	: index_( index ), descending_( descending )
+{
+	const cell_size_t size = index.size();
+	disjoint sets( size );
+	std::vector<cell_size_t> nodeOf( size, none ), owner( size, none );
+	std::vector<bool> added( size, false );
+	
+	for ( cell_size_t step = 0; step < size; ++step )
+	{
+		cell_size_t c = index.cell( descending ? size - 1 - step : step );
+		cell_size_t roots[6], count = 0;
+		
+		for ( int spoke = 0; spoke < 6; ++spoke )
+		{
+			cell_size_t n = data[c].link[spoke];
+			
+			if ( n == geoData::nolink || !added[n] )
+				continue;
+				
+			n = sets.find( n );
+			
+			if ( std::find( roots, roots + count, n ) == roots + count )
+				roots[count++] = n;
+		}
+		
+		added[c] = true;
+		
+		if ( count == 1 )
+		{
+			// Grows the neighbouring component.
+			owner[step] = nodeOf[roots[0]];
+			nodeOf[sets.join( roots[0], c )] = owner[step];
+			continue;
+		}
+		
+		// A new peak, or a saddle joining every neighbouring component.
+		
+		node fresh = {step, none, 1};
+		cell_size_t root = c;
+		
+		for ( cell_size_t r = 0; r < count; ++r )
+		{
+			nodes_[nodeOf[roots[r]]].parent = cell_size_t( nodes_.size() );
+			fresh.base += sets.size[roots[r]];
+			root = sets.join( root, roots[r] );
+		}
+		
+		nodeOf[root] = cell_size_t( nodes_.size() );
+		nodes_.push_back( fresh );
+	}
+	
+	// Group the growth steps by node. Steps go in increasing order, so each
+	// group ends up sorted.
+	
+	grownStart_.assign( nodes_.size() + 1, 0 );
+	
+	for ( auto const n : owner )
+		if ( n != none )
+			++grownStart_[n + 1];
+			
+	for ( std::size_t n = 0; n < nodes_.size(); ++n )
+		grownStart_[n + 1] += grownStart_[n];
+		
+	grown_.resize( grownStart_.back() );
+	std::vector<cell_size_t> next( grownStart_.begin(), grownStart_.end() - 1 );
+	
+	for ( cell_size_t step = 0; step < size; ++step )
+		if ( owner[step] != none )
+			grown_[next[owner[step]]++] = step;
+}
+
+std::vector<zw::cell_size_t> zw::components::sizes( const cell_size_t steps )
+const
+{
+	// Components that exist after the given steps are the nodes that had
+	// appeared and not yet merged into a parent.
+	
+	std::vector<cell_size_t> result;
+	
+	for ( std::size_t n = 0; n < nodes_.size(); ++n )
+	{
+		const node &here = nodes_[n];
+		
+		if ( here.step >= steps )
+			break;
+			
+		if ( here.parent != none && nodes_[here.parent].step < steps )
+			continue;
+			
+		auto begin = grown_.begin() + grownStart_[n];
+		auto end = grown_.begin() + grownStart_[n + 1];
+		result.push_back( here.base + cell_size_t( std::lower_bound( begin, end,
+		                  steps ) - begin ) );
+	}
+	
+	std::sort( result.begin(), result.end(), std::greater<cell_size_t>() );
+	return result;
+}
+
+std::vector<zw::cell_size_t> zw::components::at( const real_t level ) const
+{
+	cell_size_t below = index_.flooded( level );
+	return sizes( descending_ ? index_.size() - below : below );
+}
+
@@ -0,0 +1,57 @@
+#ifndef COMPONENTS_HPP
+#define COMPONENTS_HPP
+
+// ZaWarudo Headers
+#include "config.hpp"
+#include "geodesic.hpp"
+#include "ranking.hpp"
+
+namespace zw
+{
+	//
+	// Merge tree of connected components as cells are added in elevation
+	// order, highest first for landmasses or lowest first for oceans. Built
+	// with one union-find sweep over the links, it gives the components at
+	// any sea level without touching the grid again.
+	//
+	class components
+	{
+	public:
+	
+		// Constructors
+		
+		components( const geoData::geo_ptr &data, const ranking &index,
+		            const bool descending );
+		            
+		// Functions
+		
+		// Sizes of the components formed by the first steps cells of the
+		// sweep, largest first.
+		std::vector<cell_size_t> sizes( const cell_size_t steps ) const;
+		
+		// Sizes of the landmasses or oceans at a sea level.
+		std::vector<cell_size_t> at( const real_t level ) const;
+		
+	private:
+	
+		// A component appears at a peak (or pit) and ends when it merges
+		// into its parent at a saddle.
+		struct node
+		{
+			cell_size_t step, parent, base;
+		};
+		
+		const ranking &index_;
+		bool descending_;
+		std::vector<node> nodes_;
+		
+		// Steps of the cells each node grew by after it appeared, grouped by
+		// node in sweep order.
+		std::vector<cell_size_t> grownStart_, grown_;
+		
+		static const cell_size_t none = std::numeric_limits<cell_size_t>::max();
+	};
+}
+
+#endif
+
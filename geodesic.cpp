@@ -2,7 +2,9 @@
 #include "geodesic.hpp"
 
 // Utility Headers
+#include "parallel.hpp"
 #include "serialize.hpp"
+#include "statistics.hpp"
 
 #if REGION_LIMIT < 12
 #	error "REGION_LIMIT <12 is not supported."
@@ -41,165 +43,255 @@ static zw::region_t region_split( const zw::region_t a, const zw::region_t b )
 	return ( flip = !flip ) ? std::max( a, b ) : std::min( a, b );
 }
 
-//
-// Public API
-//
-
-zw::range_t zw::geoData::extremes( const geo_ptr &data, const cell_size_t size )
+// Elevations splitting the grid at each coverage. The elevation for a
+// coverage sits between the two cells on either side of it, so we need both
+// order statistics. When findRange is set the extremes come out of the same
+// passes and are stored in range.
+static std::vector<zw::real_t> coverage( const zw::real_t *field,
+        const zw::cell_size_t size, const std::vector<zw::real_t> &percents,
+        zw::range_t &range, const bool findRange )
 {
-	real_t maxima = 0;
-	real_t minima = std::numeric_limits<real_t>::max();
+	std::vector<zw::cell_size_t> ranks;
 	
-	for ( cell_size_t c = 0; c < size; ++c )
+	for ( auto percent : percents )
 	{
-		real_t magnitude = data[c].v.magnitude();
-		
-		if ( magnitude < minima ) minima = magnitude;
+		assert( percent >= 0 && percent < 1.0 );
 		
-		if ( magnitude > maxima ) maxima = magnitude;
+		zw::cell_size_t rank = std::max<zw::cell_size_t>( 1,
+		                       std::min<zw::cell_size_t>( size - 1, zw::cell_size_t( percent * size + 0.5 ) ) );
+		ranks.push_back( rank - 1 );
+		ranks.push_back( rank );
 	}
 	
-	assert( minima <= maxima );
-	return std::make_pair( minima, maxima );
-}
-
-zw::real_t zw::geoData::findElevation( const geo_ptr &data,
-                                       const cell_size_t size, const real_t percent, range_t range )
-{
-	assert( range.first <= range.second );
-	assert( percent >= 0 && percent < 1.0 );
-	
-	if ( percent == 0 )
-		return 0.5 * ( range.first + range.second );
+	if ( findRange )
+	{
+		ranks.push_back( 0 );
+		ranks.push_back( size - 1 );
+	}
+	else if ( range.first == range.second )
+		return std::vector<zw::real_t>( percents.size(), range.first );
 		
-	real_t elevation = range.first;
-	real_t old = -1;
-	real_t coverage = 0;
+	auto values = zw::statistics::select( field, size, ranks );
+	std::vector<zw::real_t> elevations( percents.size() );
+	
+	if ( findRange )
+		range = std::make_pair( values[percents.size() * 2],
+		                        values[percents.size() * 2 + 1] );
+		                        
+	assert( range.first <= range.second );
 	
-	while ( coverage != percent && old != elevation && range.first < range.second )
+	for ( std::size_t p = 0; p < percents.size(); ++p )
 	{
-		old = elevation;
-		elevation = 0.5 * ( range.first + range.second );
-		cell_size_t count = 0;
+		zw::real_t below = values[p * 2];
+		zw::real_t above = values[p * 2 + 1];
 		
-		for ( cell_size_t c = 0; c < size; ++c )
-			if ( data[c].v.magnitude() < elevation )
-				++count;
-				
-		coverage = double( count ) / double( size );
+		if ( percents[p] == 0 || range.first == range.second )
+		{
+			elevations[p] = 0.5 * ( range.first + range.second );
+			continue;
+		}
+		
+		elevations[p] = 0.5 * ( below + above );
 		
-		if ( coverage < percent )
-			range.first = elevation;
-		else
-			range.second = elevation;
+		if ( !( elevations[p] > below ) )
+			elevations[p] = above;
 	}
 	
-	return elevation;
+	return elevations;
 }
 
-zw::range_t zw::geoData::rescale( const geo_ptr &data, const cell_size_t size,
-                                  const real_t seaLevel, const real_t hydro, const range_t range )
+// Coverages the survey needs: the sea level first, then each of the
+// profile's knots. Dry worlds don't use the knots.
+static std::vector<zw::real_t> surveyPercents( const zw::real_t hydro,
+        const zw::profile &shape )
 {
-	assert( range.first <= range.second );
-	assert( seaLevel > range.first && seaLevel < range.second );
-	assert( hydro >= 0 && hydro < 1.0 );
+	std::vector<zw::real_t> percents( 1, hydro );
 	
-	real_t multiplier = std::log( 1.0 / std::sqrt( seaLevel / 6371.0 ) ) + 1.0;
-	real_t targetMin, targetMax, startMountain, startShelf, startSlope, startFloor;
+	if ( hydro > 0 )
+	{
+		for ( auto const &k : shape.ocean )
+			percents.push_back( k.first * hydro );
+			
+		for ( auto const &k : shape.land )
+			percents.push_back( hydro + k.first * ( 1.0 - hydro ) );
+	}
+	
+	return percents;
+}
+
+// Splits levels found for surveyPercents back into the survey.
+static void surveyLevels( zw::geoData::survey_t &result,
+                          const std::vector<zw::real_t> &levels, const zw::real_t hydro,
+                          const zw::profile &shape )
+{
+	auto next = levels.begin();
+	result.seaLevel = *next++;
 	
 	if ( hydro > 0 )
 	{
-		targetMin = seaLevel - ( 18.0 / 6371.0 ) * multiplier * seaLevel;
-		targetMax = seaLevel + ( 13.4 / 6371.0 ) * multiplier * seaLevel;
-		startFloor = findElevation( data, size, 0.15 * hydro, range );
-		startSlope = findElevation( data, size, 0.70 * hydro, range );
-		startShelf = findElevation( data, size, 0.85 * hydro, range );
-		startMountain = findElevation( data, size, ( 1.0 / 3.0 ) * hydro + 2.0 / 3.0,
-		                               range );
+		result.ocean.assign( next, next + shape.ocean.size() );
+		result.land.assign( next + shape.ocean.size(), levels.end() );
 	}
-	else
+}
+
+//
+// Public API
+//
+
+void zw::geoData::perturb( const geo_ptr &data, field_ptr &elevation,
+                           const cell_size_t size, const counterRng &rng, const std::uint64_t first,
+                           const std::uint64_t count )
+{
+	const real_t raise = 1.001, lower = 1 / 1.001;
+	
+	// A cell at elevation e lies on the far side of plane p when
+	// e (p . v) > p . p, so each plane comes down to its normal, its
+	// squared length and the factor for either side.
+	
+	std::vector<real_t> px( count ), py( count ), pz( count ), reach( count );
+	std::vector<real_t> beyond( count ), within( count );
+	
+	for ( std::uint64_t k = 0; k < count; ++k )
 	{
-		targetMin = seaLevel - ( 15.7 / 6371.0 ) * multiplier * seaLevel;
-		targetMax = seaLevel + ( 15.7 / 6371.0 ) * multiplier * seaLevel;
+		const std::uint64_t index = ( first + k ) * 4;
+		const vector plane( rng.uniform( index, -1, 1 ), rng.uniform( index + 1, -1, 1 ),
+		                    rng.uniform( index + 2, -1, 1 ) );
+		const bool flip = rng.uniform( index + 3 ) < 0.5;
+		
+		px[k] = plane.x;
+		py[k] = plane.y;
+		pz[k] = plane.z;
+		reach[k] = plane.dotProduct( plane );
+		beyond[k] = flip ? raise : lower;
+		within[k] = flip ? lower : raise;
 	}
 	
-	for ( cell_size_t c = 0; c < size; ++c )
+	// Blocks of cells stay in cache while every plane passes over them, so
+	// the grid is read once however many planes there are. Planes run in
+	// order for each cell and cells don't depend on each other, so the
+	// result is the same for any thread count or block size.
+	
+	parallel::spans( size, [&]( unsigned, cell_size_t begin, cell_size_t end )
 	{
-		real_t elevation = data[c].v.magnitude();
-		real_t change, base;
+		const cell_size_t block = 1024;
+		real_t x[block], y[block], z[block], e[block];
 		
-		if ( hydro > 0 )
+		for ( cell_size_t at = begin; at < end; at += block )
 		{
-			if ( elevation < startFloor )
-			{
-				// Ocean Trench
-				change = ( seaLevel - targetMin ) * 0.4;
-				base = ( seaLevel - targetMin ) * 0.6;
-				multiplier = ( startFloor - elevation ) / ( startFloor - range.first );
-				elevation = seaLevel - base - change * multiplier;
-			}
-			else if ( elevation < startSlope )
-			{
-				// Ocean Floor
-				change = ( seaLevel - targetMin ) * 0.2;
-				base = ( seaLevel - targetMin ) * 0.4;
-				multiplier = ( startSlope - elevation ) / ( startSlope - startFloor );
-				elevation = seaLevel - base - change * multiplier;
-			}
-			else if ( elevation < startShelf )
-			{
-				// Ocean Drop
-				change = ( seaLevel - targetMin ) * 0.3;
-				base = ( seaLevel - targetMin ) * 0.1;
-				multiplier = ( startShelf - elevation ) / ( startShelf - startSlope );
-				elevation = seaLevel - base - change * multiplier;
-			}
-			else if ( elevation < seaLevel )
-			{
-				// Continental Shelf
-				change = ( seaLevel - targetMin ) * 0.1;
-				base = 0;
-				multiplier = ( seaLevel - elevation ) / ( seaLevel - startShelf );
-				elevation = seaLevel - base - change * multiplier;
-			}
-			else if ( elevation < startMountain )
-			{
-				// Plains
-				change = ( targetMax - seaLevel ) * 0.125;
-				base = ( targetMax - seaLevel ) * 0.875;
-				multiplier = ( startMountain - elevation ) / ( startMountain - seaLevel );
-				elevation = targetMax - base - change * multiplier;
-			}
-			else
-			{
-				// Mountain
-				change = ( targetMax - seaLevel ) * 0.875;
-				base = 0;
-				multiplier = ( range.second - elevation ) / ( range.second - startMountain );
-				elevation = targetMax - base - change * multiplier;
-			}
-		}
-		else
-		{
-			if ( elevation < seaLevel )
+			const cell_size_t cells = std::min( block, end - at );
+			
+			for ( cell_size_t i = 0; i < cells; ++i )
 			{
-				// Ocean
-				change = seaLevel - targetMin;
-				multiplier = ( seaLevel - elevation ) / ( seaLevel - range.first );
-				elevation = seaLevel - change * multiplier;
+				x[i] = data[at + i].v.x;
+				y[i] = data[at + i].v.y;
+				z[i] = data[at + i].v.z;
+				e[i] = elevation[at + i];
 			}
-			else
+			
+			for ( std::uint64_t k = 0; k < count; ++k )
 			{
-				// Land
-				change = targetMax - seaLevel;
-				multiplier = ( range.second - elevation ) / ( range.second - seaLevel );
-				elevation = targetMax - change * multiplier;
+				const real_t nx = px[k], ny = py[k], nz = pz[k], r = reach[k];
+				const real_t farSide = beyond[k], nearSide = within[k];
+				
+				for ( cell_size_t i = 0; i < cells; ++i )
+					e[i] *= ( e[i] * ( nx * x[i] + ny * y[i] + nz * z[i] ) > r ) ? farSide : nearSide;
 			}
+			
+			std::copy( e, e + cells, elevation.get() + at );
 		}
+	} );
+}
+
+zw::range_t zw::geoData::extremes( const field_ptr &elevation,
+                                   const cell_size_t size )
+{
+	range_t range = statistics::extremes( elevation.get(), size );
+	assert( range.first <= range.second );
+	return range;
+}
+
+zw::real_t zw::geoData::findElevation( const field_ptr &elevation,
+                                       const cell_size_t size, const real_t percent, range_t range )
+{
+	return findElevations( elevation, size, std::vector<real_t>( 1, percent ),
+	                       range )[0];
+}
+
+std::vector<zw::real_t> zw::geoData::findElevations( const field_ptr &elevation,
+        const cell_size_t size, const std::vector<real_t> &percents,
+        const range_t range )
+{
+	range_t known = range;
+	return coverage( elevation.get(), size, percents, known, false );
+}
+
+zw::geoData::survey_t zw::geoData::survey( const field_ptr &elevation,
+        const cell_size_t size, const real_t hydro, const profile &shape )
+{
+	survey_t result;
+	auto levels = coverage( elevation.get(), size, surveyPercents( hydro, shape ),
+	                        result.range, true );
+	surveyLevels( result, levels, hydro, shape );
+	return result;
+}
+
+zw::geoData::survey_t zw::geoData::survey( const sketch &heights,
+        const real_t hydro, const profile &shape )
+{
+	survey_t result;
+	result.range = heights.range();
+	surveyLevels( result, heights.quantiles( surveyPercents( hydro, shape ) ), hydro,
+	              shape );
+	return result;
+}
+
+zw::range_t zw::geoData::rescale( field_ptr &elevation, const cell_size_t size,
+                                  const real_t hydro, const survey_t &survey, const profile &shape,
+                                  const real_t scale )
+{
+	// Radius scaling is linear, so it folds into the curve and we only need
+	// to touch each cell once.
+	
+	const range_t range = survey.range;
+	const real_t seaLevel = survey.seaLevel * scale;
+	
+	assert( range.first <= range.second );
+	assert( survey.seaLevel >= range.first && survey.seaLevel <= range.second );
+	assert( hydro >= 0 && hydro < 1.0 );
+	
+	const real_t magnitude = ( std::log( 1.0 / std::sqrt( seaLevel / 6371.0 ) ) +
+	                           1.0 ) * seaLevel / 6371.0;
+	real_t targetMin, targetMax;
+	curve transfer;
+	
+	if ( hydro > 0 )
+	{
+		targetMin = seaLevel - shape.depth * magnitude;
+		targetMax = seaLevel + shape.height * magnitude;
+		transfer.knot( range.first, targetMin );
+		
+		for ( std::size_t k = 0; k < shape.ocean.size(); ++k )
+			transfer.knot( survey.ocean[k],
+			               seaLevel + shape.ocean[k].second * ( seaLevel - targetMin ) );
+			               
+		transfer.knot( survey.seaLevel, seaLevel );
 		
-		data[c].v = data[c].v.normalize() * elevation;
+		for ( std::size_t k = 0; k < shape.land.size(); ++k )
+			transfer.knot( survey.land[k],
+			               seaLevel + shape.land[k].second * ( targetMax - seaLevel ) );
+			               
+		transfer.knot( range.second, targetMax );
+	}
+	else
+	{
+		targetMin = seaLevel - shape.relief * magnitude;
+		targetMax = seaLevel + shape.relief * magnitude;
+		transfer.knot( range.first, targetMin );
+		transfer.knot( survey.seaLevel, seaLevel );
+		transfer.knot( range.second, targetMax );
 	}
 	
+	transfer.apply( elevation.get(), size );
 	return std::make_pair( targetMin, targetMax );
 }
 
@@ -369,6 +461,47 @@ void zw::geoData::subdivide( geo_ptr &data, cell_size_t &extant )
 	extant = created;
 }
 
+std::vector<std::pair<zw::cell_size_t, zw::cell_size_t>> zw::geoData::parents(
+            const geo_ptr &data, const int iterations )
+{
+	std::vector<std::pair<cell_size_t, cell_size_t>> pairs( cellsPerIteration( iterations ),
+	        std::make_pair( cell_size_t( nolink ), cell_size_t( nolink ) ) );
+	        
+	// A cell starts out linked to its parents on link[0] and link[3], and
+	// every cell later made on the line between them has its line
+	// neighbours on those two links as well. Walking the line from a cell
+	// ends at the first cell older than its own level.
+	
+	auto trace = [&]( const cell_size_t c, const int spoke, const cell_size_t born )
+	{
+		cell_size_t from = c, at = data[c].link[spoke];
+		
+		while ( at >= born )
+		{
+			assert( data[at].link[0] == from || data[at].link[3] == from );
+			cell_size_t next = ( data[at].link[0] == from ) ? data[at].link[3] : data[at].link[0];
+			from = at;
+			at = next;
+		}
+		
+		return at;
+	};
+	
+	for ( int level = 1; level <= iterations; ++level )
+	{
+		const cell_size_t first = cellsPerIteration( level - 1 );
+		const cell_size_t born = cellsPerIteration( level );
+		
+		parallel::spans( born - first, [&]( unsigned, cell_size_t begin, cell_size_t end )
+		{
+			for ( cell_size_t c = first + begin; c < first + end; ++c )
+				pairs[c] = std::make_pair( trace( c, 0, born ), trace( c, 3, born ) );
+		} );
+	}
+	
+	return pairs;
+}
+
 void zw::geoData::icosahedron( geo_ptr &data, cell_size_t &extant )
 {
 	real_t t = ( 1.0 + std::sqrt( 5.0 ) ) / 2.0;
@@ -495,8 +628,8 @@ void zw::geoData::icosahedron( geo_ptr &data, cell_size_t &extant )
 	extant = 12;
 }
 
-bool zw::geoData::load( geo_ptr &data, const cell_size_t size,
-                        const std::string &file )
+bool zw::geoData::load( geo_ptr &data, field_ptr &elevation, field_ptr &base,
+                        real_t &seaLevel, const cell_size_t size, const std::string &file )
 {
 	serialize::input handle( file );
 	
@@ -506,7 +639,9 @@ bool zw::geoData::load( geo_ptr &data, const cell_size_t size,
 		
 		if ( sizeof( geoData ) == handle.read<std::size_t>() )
 		{
-			if ( size <= handle.read<cell_size_t>() )
+			cell_size_t stored = handle.read<cell_size_t>();
+			
+			if ( size <= stored )
 			{
 				for ( cell_size_t c = 0; c < size; ++c )
 				{
@@ -515,6 +650,34 @@ bool zw::geoData::load( geo_ptr &data, const cell_size_t size,
 					handle.read( data[c].v.y );
 					handle.read( data[c].v.z );
 					handle.read( data[c].region );
+					
+					// Files keep the elevation as the vector's magnitude.
+					elevation[c] = data[c].v.magnitude();
+					data[c].v /= elevation[c];
+				}
+				
+				// The base heightmap follows every stored cell, and older
+				// files don't have one.
+				
+				handle.skip<char>( std::size_t( stored - size ) * ( sizeof( data[0].link ) +
+				                   3 * sizeof( real_t ) + sizeof( region_t ) ) );
+				base.reset();
+				seaLevel = 0;
+				
+				if ( handle.read<std::size_t>() == sizeof( real_t ) && handle.exists() )
+				{
+					base = field_ptr( new real_t[size] );
+					handle.read( base.get(), size );
+					
+					if ( !handle.exists() )
+						base.reset();
+					else if ( handle.read<std::size_t>() == sizeof( real_t ) && handle.exists() )
+					{
+						handle.read( seaLevel );
+						
+						if ( !handle.exists() )
+							seaLevel = 0;
+					}
 				}
 				
 				return true;
@@ -525,7 +688,8 @@ bool zw::geoData::load( geo_ptr &data, const cell_size_t size,
 	return false;
 }
 
-void zw::geoData::save( geo_ptr &data, const cell_size_t size,
+void zw::geoData::save( const geo_ptr &data, const field_ptr &elevation,
+                        const field_ptr &base, const real_t seaLevel, const cell_size_t size,
                         const std::string &file )
 {
 	serialize::output handle( file );
@@ -535,11 +699,24 @@ void zw::geoData::save( geo_ptr &data, const cell_size_t size,
 	
 	for ( cell_size_t c = 0; c < size; ++c )
 	{
+		vector position = data[c].v * elevation[c];
 		handle.write( data[c].link, 6 );
-		handle.write( data[c].v.x );
-		handle.write( data[c].v.y );
-		handle.write( data[c].v.z );
+		handle.write( position.x );
+		handle.write( position.y );
+		handle.write( position.z );
 		handle.write( data[c].region );
 	}
+	
+	if ( base )
+	{
+		handle.write<std::size_t>( sizeof( real_t ) );
+		handle.write( base.get(), size );
+		
+		if ( seaLevel > 0 )
+		{
+			handle.write<std::size_t>( sizeof( real_t ) );
+			handle.write( seaLevel );
+		}
+	}
 }
 
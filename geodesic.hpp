@@ -3,6 +3,9 @@
 
 // ZaWarudo Headers
 #include "config.hpp"
+#include "hypsometry.hpp"
+#include "random.hpp"
+#include "sketch.hpp"
 
 // Utility Headers
 #include "vector.hpp"
@@ -17,6 +20,7 @@ namespace zw
 	struct geoData
 	{
 		using geo_ptr = std::unique_ptr<geoData[]>;
+		using field_ptr = std::unique_ptr<real_t[]>;
 		geoData() = default;
 		geoData( const geoData & ) = default;
 		geoData &operator=( const geoData & ) = default;
@@ -38,51 +42,68 @@ namespace zw
 		}
 		
 		cell_size_t link[6];
-		vector v;
+		vector v; // unit direction, elevation is kept in its own field
 		region_t region;
 		
 		// Algorithm Borrowed From
 		// http://freespace.virgin.net/hugo.elias/models/m_landsp.htm
 		//
-		template<class R>
-		static void perturb( geo_ptr &data, const cell_size_t size, R &rng )
-		{
-			std::uniform_real_distribution<real_t> genReal( -1.0, 1.0 );
-			vector plane( genReal( rng ), genReal( rng ), genReal( rng ) );
-			bool flip = genReal( rng ) < 0;
-			
-			for ( cell_size_t c = 0; c < size; ++c )
-			{
-				if ( ( plane.dotProduct( data[c].v - plane ) > 0 && flip ) || !flip )
-					data[c].v *= 1.001;
-				else
-					data[c].v /= 1.001;
-			}
-		}
+		// Runs iterations [first, first + count), each raising the cells on
+		// one side of a random plane and lowering the rest. The plane of each
+		// iteration comes from the numbers at that iteration's indices, so
+		// cells can be split over any number of threads and iterations run
+		// in any grouping with the same result.
+		//
+		static void perturb( const geo_ptr &data, field_ptr &elevation,
+		                     const cell_size_t size, const counterRng &rng, const std::uint64_t first,
+		                     const std::uint64_t count );
 		
-		static range_t extremes( const geo_ptr &data, const cell_size_t size );
-		static real_t findElevation( const geo_ptr &data, const cell_size_t size,
-		                             const real_t percent, range_t range );
-		static range_t rescale( const geo_ptr &data, const cell_size_t size,
-		                        const real_t seaLevel, const real_t hydro, const range_t range );
+		static range_t extremes( const field_ptr &elevation, const cell_size_t size );
+		static real_t findElevation( const field_ptr &elevation,
+		                             const cell_size_t size, const real_t percent, range_t range );
+		static std::vector<real_t> findElevations( const field_ptr &elevation,
+		        const cell_size_t size, const std::vector<real_t> &percents,
+		        const range_t range );
 		                        
-		static real_t findElevation( const geo_ptr &data, const cell_size_t size,
-		                             const real_t percent )
+		static real_t findElevation( const field_ptr &elevation,
+		                             const cell_size_t size, const real_t percent )
 		{
-			return findElevation( data, size, percent, extremes( data, size ) );
+			return findElevation( elevation, size, percent, extremes( elevation, size ) );
 		}
-		static range_t rescale( const geo_ptr &data, const cell_size_t size,
-		                        const real_t seaLevel, const real_t hydro )
+		
+		// Every elevation the hypsometric rescale depends on: the extremes, the
+		// sea level and the elevation at each of the profile's knots.
+		struct survey_t
 		{
-			return rescale( data, size, seaLevel, hydro, extremes( data, size ) );
-		}
+			range_t range;
+			real_t seaLevel;
+			std::vector<real_t> ocean, land;
+		};
+		
+		static survey_t survey( const field_ptr &elevation, const cell_size_t size,
+		                        const real_t hydro, const profile &shape );
+		static survey_t survey( const sketch &heights, const real_t hydro,
+		                        const profile &shape );
+		static range_t rescale( field_ptr &elevation, const cell_size_t size,
+		                        const real_t hydro, const survey_t &survey, const profile &shape,
+		                        const real_t scale = 1 );
 		
 		static void subdivide( geo_ptr &data, cell_size_t &extant );
+		
+		// The two cells each cell of a grid subdivided the given number of
+		// times was created between, nolink for the icosahedron's twelve.
+		static std::vector<std::pair<cell_size_t, cell_size_t>> parents( const geo_ptr &data,
+		        const int iterations );
 		static void icosahedron( geo_ptr &data, cell_size_t &extant );
 		
-		static bool load( geo_ptr &data, const cell_size_t size,
-		                  const std::string &file );
-		static void save( geo_ptr &data, const cell_size_t size,
+		// Worlds keep the heightmap from before any rescaling as a second
+		// layer. Loading leaves base empty if the file doesn't have one.
+		// After it comes the sea level the world was last flooded to, which
+		// is 0 for dry worlds and files that don't have one.
+		static bool load( geo_ptr &data, field_ptr &elevation, field_ptr &base,
+		                  real_t &seaLevel, const cell_size_t size, const std::string &file );
+		static void save( const geo_ptr &data, const field_ptr &elevation,
+		                  const field_ptr &base, const real_t seaLevel, const cell_size_t size,
 		                  const std::string &file );
 		                  
 		static const cell_size_t nolink = std::numeric_limits<cell_size_t>::max();
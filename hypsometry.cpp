@@ -0,0 +1,184 @@
+// ZaWarudo Headers
+#include "hypsometry.hpp"
+#include "parallel.hpp"
+
+// C++ STL
+#include <fstream>
+#include <sstream>
+
+#if defined( __AVX2__ )
+#	include <immintrin.h>
+#endif
+
+//
+// Internal Stuff
+//
+
+// Knots must rise in both coverage and level, with coverages inside (0, 1)
+// and levels inside (low, high), or the transfer stops being monotone and
+// cells change order.
+static bool validKnots( const std::vector<zw::profile::knot_t> &knots, const zw::real_t low,
+                        const zw::real_t high )
+{
+	zw::real_t coverage = 0;
+	zw::real_t level = low;
+	
+	for ( auto const &k : knots )
+	{
+		if ( k.first <= coverage || k.first >= 1.0 )
+			return false;
+			
+		if ( k.second <= level || k.second >= high )
+			return false;
+			
+		coverage = k.first;
+		level = k.second;
+	}
+	
+	return true;
+}
+
+//
+// Public API
+//
+
+zw::profile zw::profile::terran()
+{
+	profile p;
+	p.depth = 18.0;
+	p.height = 13.4;
+	p.relief = 15.7;
+	
+	// Trench, Floor, Drop, Shelf
+	p.ocean = {knot_t( 0.15, -0.6 ), knot_t( 0.70, -0.4 ), knot_t( 0.85, -0.1 )};
+	
+	// Plains, Mountain
+	p.land = {knot_t( 2.0 / 3.0, 0.125 )};
+	
+	return p;
+}
+
+bool zw::profile::load( const std::string &file )
+{
+	std::ifstream handle( file );
+	
+	if ( !handle.good() )
+		return false;
+		
+	// One setting per line: "depth|height|relief KM" or "ocean|land COVERAGE
+	// LEVEL". Everything after a '#' is ignored.
+	
+	profile p = terran();
+	p.ocean.clear();
+	p.land.clear();
+	
+	std::string line;
+	
+	while ( std::getline( handle, line ) )
+	{
+		std::istringstream fields( line.substr( 0, line.find( '#' ) ) );
+		std::string key;
+		real_t first, second;
+		
+		if ( !( fields >> key ) )
+			continue;
+			
+		if ( key == "depth" && fields >> first )
+			p.depth = first;
+		else if ( key == "height" && fields >> first )
+			p.height = first;
+		else if ( key == "relief" && fields >> first )
+			p.relief = first;
+		else if ( key == "ocean" && fields >> first >> second )
+			p.ocean.push_back( knot_t( first, second ) );
+		else if ( key == "land" && fields >> first >> second )
+			p.land.push_back( knot_t( first, second ) );
+		else
+			return false;
+	}
+	
+	if ( !validKnots( p.ocean, -1, 0 ) || !validKnots( p.land, 0, 1 ) )
+		return false;
+		
+	if ( p.depth <= 0 || p.height <= 0 || p.relief <= 0 )
+		return false;
+		
+	*this = p;
+	return true;
+}
+
+void zw::curve::knot( const real_t input, const real_t output )
+{
+	assert( x_.empty() || input >= x_.back() );
+	
+	if ( !x_.empty() )
+	{
+		// Zero-width segments can never be selected.
+		real_t width = input - x_.back();
+		slope_.back() = ( width > 0 ) ? ( output - y_.back() ) / width : 0;
+	}
+	
+	x_.push_back( input );
+	y_.push_back( output );
+	slope_.push_back( 0 );
+}
+
+void zw::curve::apply( real_t *field, const cell_size_t size ) const
+{
+	assert( x_.size() >= 2 );
+	
+	// The segment index is a count of interior knots at or below the input,
+	// so there is no branching per cell.
+	
+	parallel::spans( size, [&]( unsigned, cell_size_t begin, cell_size_t end )
+	{
+		cell_size_t c = begin;
+		
+#if defined( __AVX2__ ) && SPACE_SAVING == 2
+
+		for ( ; c + 8 <= end; c += 8 )
+		{
+			__m256 input = _mm256_loadu_ps( field + c );
+			__m256i s = _mm256_setzero_si256();
+			
+			for ( std::size_t k = 1; k + 1 < x_.size(); ++k )
+			{
+				__m256 above = _mm256_cmp_ps( input, _mm256_set1_ps( x_[k] ), _CMP_GE_OQ );
+				s = _mm256_sub_epi32( s, _mm256_castps_si256( above ) );
+			}
+			
+			__m256 x = _mm256_i32gather_ps( x_.data(), s, 4 );
+			__m256 y = _mm256_i32gather_ps( y_.data(), s, 4 );
+			__m256 slope = _mm256_i32gather_ps( slope_.data(), s, 4 );
+			_mm256_storeu_ps( field + c, _mm256_fmadd_ps( slope, _mm256_sub_ps( input, x ),
+			                  y ) );
+		}
+		
+#elif defined( __AVX2__ )
+
+		for ( ; c + 4 <= end; c += 4 )
+		{
+			__m256d input = _mm256_loadu_pd( field + c );
+			__m128i s = _mm_setzero_si128();
+			
+			for ( std::size_t k = 1; k + 1 < x_.size(); ++k )
+			{
+				__m256d above = _mm256_cmp_pd( input, _mm256_set1_pd( x_[k] ), _CMP_GE_OQ );
+				__m128i lanes = _mm256_castsi256_si128( _mm256_permutevar8x32_epi32(
+				                    _mm256_castpd_si256( above ), _mm256_setr_epi32( 0, 2, 4, 6, 0, 2, 4, 6 ) ) );
+				s = _mm_sub_epi32( s, lanes );
+			}
+			
+			__m256d x = _mm256_i32gather_pd( x_.data(), s, 8 );
+			__m256d y = _mm256_i32gather_pd( y_.data(), s, 8 );
+			__m256d slope = _mm256_i32gather_pd( slope_.data(), s, 8 );
+			_mm256_storeu_pd( field + c, _mm256_fmadd_pd( slope, _mm256_sub_pd( input, x ),
+			                  y ) );
+		}
+		
+#endif
+
+		for ( ; c < end; ++c )
+			field[c] = ( *this )( field[c] );
+	} );
+}
@@ -0,0 +1,64 @@
+#ifndef HYPSOMETRY_HPP
+#define HYPSOMETRY_HPP
+
+// ZaWarudo Headers
+#include "config.hpp"
+
+// C++ STL
+#include <string>
+
+namespace zw
+{
+	//
+	// How elevations are spread out around sea level. Knots map a coverage
+	// (fraction of the ocean from the deepest cell up, or of the land from
+	// the shore up) to a level (-1 is the deepest trench, 0 is sea level, 1
+	// is the highest peak). The end points are implicit.
+	//
+	struct profile
+	{
+		using knot_t = std::pair<real_t, real_t>;
+		
+		// Relief at Earth's radius, in km. Dry worlds use relief both ways.
+		real_t depth, height, relief;
+		std::vector<knot_t> ocean, land;
+		
+		static profile terran();
+		bool load( const std::string &file );
+	};
+	
+	//
+	// Piecewise-linear transfer function, extended past its end knots.
+	// Knots must be added in order of input.
+	//
+	class curve
+	{
+	public:
+	
+		// Functions
+		
+		void knot( const real_t input, const real_t output );
+		void apply( real_t *field, const cell_size_t size ) const;
+		
+		real_t operator()( const real_t input ) const
+		{
+			std::size_t s = segment( input );
+			return y_[s] + slope_[s] * ( input - x_[s] );
+		}
+		
+	private:
+		std::size_t segment( const real_t input ) const
+		{
+			std::size_t s = 0;
+			
+			for ( std::size_t k = 1; k + 1 < x_.size(); ++k )
+				s += input >= x_[k];
+				
+			return s;
+		}
+		
+		std::vector<real_t> x_, y_, slope_;
+	};
+}
+
+#endif
@@ -24,23 +24,44 @@ OTHER DEALINGS IN THE SOFTWARE.
 */
 
 #include <algorithm>
+#include <cassert>
+#include <ctime>
+#include <numeric>
 
 #include "noise.h"
 
+#if defined(__AVX2__)
+#include <immintrin.h>
+#endif
+
 namespace noise {
 
-double fade(double t) {
+const char *kernels() {
+#if defined(__AVX512F__)
+    return "avx512";
+#elif defined(__AVX2__)
+    return "avx2";
+#else
+    return "scalar";
+#endif
+}
+
+template<typename T>
+T fade(T t) {
     return t * t * t * (t * (t * 6 - 15) + 10);
 }
 
-double grad(int hash, double x, double y, double z) {
+template<typename T>
+T grad(int hash, T x, T y, T z) {
     int h = hash & 15;
-    double u = h < 8 ? x : y;
-    double v = h < 4 ? y : h == 12 || h == 14 ? x : z;
+    T u = h < 8 ? x : y;
+    T v = h < 4 ? y : h == 12 || h == 14 ? x : z;
     return ((h & 1) == 0 ? u : -u) + ((h & 2) == 0 ? v : -v);
 }
 
-Perlin::Perlin(uint32_t seed) {
+static std::array<int32_t, 512> permutation(uint32_t seed) {
+    std::array<int32_t, 512> p;
+
     if(!seed) {
         seed = time(0);
     }
@@ -53,9 +74,110 @@ Perlin::Perlin(uint32_t seed) {
     std::shuffle(p.begin(), mid_range, engine); //Shuffle the lower half
     std::copy(p.begin(), mid_range, mid_range); //Copy the lower half to the upper half
     //p now has the numbers 0-255, shuffled, and duplicated
+    return p;
+}
+
+// Blend weight (1 - cos(t pi)) / 2 for t in [0, 1], written as
+// (1 + sin(s)) / 2 with s in [-pi/2, pi/2]. Taylor terms of sin(s) / s in
+// s^2 up to s^18, which is good to within a couple of ulps on that range.
+// Single precision only needs the terms from s^12 down, and the polynomial
+// blend stops at s^8.
+static const double sinTaylor[] = {
+    -1.0 / 121645100408832000.0, 1.0 / 355687428096000.0,
+    -1.0 / 1307674368000.0, 1.0 / 6227020800.0, -1.0 / 39916800.0,
+    1.0 / 362880.0, -1.0 / 5040.0, 1.0 / 120.0, -1.0 / 6.0, 1.0
+};
+
+static const int sinTaylorFloat = 3;
+static const int sinTaylorShort = 5;
+
+// The blend weight at 256 even steps of t, and one past the end.
+static const std::size_t blendSteps = 256;
+
+static std::array<double, blendSteps + 1> tabulate() {
+    std::array<double, blendSteps + 1> table;
+    for (std::size_t i = 0; i <= blendSteps; ++i)
+        table[i] = (1.0 - std::cos(M_PI * i / blendSteps)) * 0.5;
+    return table;
+}
+
+static const std::array<double, blendSteps + 1> blendTable = tabulate();
+
+// The same steps rounded once to single precision, for the float kernels.
+static std::array<float, blendSteps + 1> narrow() {
+    std::array<float, blendSteps + 1> table;
+    std::copy(blendTable.begin(), blendTable.end(), table.begin());
+    return table;
+}
+
+static const std::array<float, blendSteps + 1> blendTableFloat = narrow();
+
+// Passed to the batch kernels in place of the first series term, asks for
+// the table instead.
+static const int blendLookup = -1;
+
+template<typename T>
+static T mix(T f, T a, T b) {
+    return (T(1) - f) * a + f * b;
 }
 
-double Perlin::noise(double x, double y, double z) const {
+template<typename T>
+Perlin<T>::Perlin(uint32_t seed, Blend blend): p(permutation(seed)), blend_(blend) {}
+
+template<typename T>
+T Perlin<T>::blend(T t, T &slope) const {
+    switch (blend_) {
+    case Blend::polynomial: {
+        const T s = (t - T(0.5)) * T(M_PI);
+        const T q = s * s;
+        T poly = T(sinTaylor[sinTaylorShort]), dpoly = 0;
+        for (int i = sinTaylorShort + 1; i < 10; ++i) {
+            dpoly = dpoly * q + poly;
+            poly = poly * q + T(sinTaylor[i]);
+        }
+        slope = (poly + 2 * q * dpoly) * T(M_PI / 2);
+        return s * poly * T(0.5) + T(0.5);
+    }
+    case Blend::table: {
+        const T x = t * blendSteps;
+        const std::size_t i = std::min(static_cast<std::size_t>(x), blendSteps - 1);
+        const T below = T(blendTable[i]);
+        slope = (T(blendTable[i + 1]) - below) * T(blendSteps);
+        return below + (x - i) * (T(blendTable[i + 1]) - below);
+    }
+    default: {
+        // sin(t pi) from the cosine, since t pi is in [0, pi].
+        const T c = std::cos(t * T(M_PI));
+        slope = std::sqrt(std::max(T(1) - c * c, T(0))) * T(M_PI / 2);
+        return (T(1) - c) * T(0.5);
+    }
+    }
+}
+
+template<typename T>
+T Perlin<T>::blend(T t) const {
+    switch (blend_) {
+    case Blend::polynomial: {
+        const T s = (t - T(0.5)) * T(M_PI);
+        const T q = s * s;
+        T poly = T(sinTaylor[sinTaylorShort]);
+        for (int i = sinTaylorShort + 1; i < 10; ++i)
+            poly = poly * q + T(sinTaylor[i]);
+        return s * poly * T(0.5) + T(0.5);
+    }
+    case Blend::table: {
+        const T x = t * blendSteps;
+        const std::size_t i = std::min(static_cast<std::size_t>(x), blendSteps - 1);
+        const T below = T(blendTable[i]);
+        return below + (x - i) * (T(blendTable[i + 1]) - below);
+    }
+    default:
+        return (T(1) - std::cos(t * T(M_PI))) * T(0.5);
+    }
+}
+
+template<typename T>
+T Perlin<T>::noise(T x, T y, T z) const {
     //See here for algorithm: http://cs.nyu.edu/~perlin/noise/
 
     const int32_t X = static_cast<int32_t>(std::floor(x)) & 255;
@@ -66,9 +188,10 @@ double Perlin::noise(double x, double y, double z) const {
     y -= std::floor(y);
     z -= std::floor(z);
 
-    const double u = fade(x);
-    const double v = fade(y);
-    const double w = fade(z);
+    // The weight along each axis is shared by every lerp along it.
+    const T u = blend(fade(x));
+    const T v = blend(fade(y));
+    const T w = blend(fade(z));
 
     const auto A = p[X] + Y;
     const auto AA = p[A] + Z;
@@ -86,32 +209,617 @@ double Perlin::noise(double x, double y, double z) const {
     const auto PAB1 = p[AB + 1];
     const auto PBB1 = p[BB + 1];
 
-    const auto a = lerp(v,
-        lerp(u, grad(PAA, x, y, z), grad(PBA, x-1, y, z)),
-        lerp(u, grad(PAB, x, y-1, z), grad(PBB, x-1, y-1, z))
+    const auto a = mix(v,
+        mix(u, grad(PAA, x, y, z), grad(PBA, x-1, y, z)),
+        mix(u, grad(PAB, x, y-1, z), grad(PBB, x-1, y-1, z))
+    );
+
+    const auto b = mix(v,
+        mix(u, grad(PAA1, x, y, z-1), grad(PBA1, x-1, y, z-1)),
+        mix(u, grad(PAB1, x, y-1, z-1), grad(PBB1, x-1, y-1, z-1))
+    );
+
+    return mix(w, a, b);
+}
+
+template<typename T>
+T Perlin<T>::noise(T x, T y, T z, T *gradient) const {
+    const int32_t X = static_cast<int32_t>(std::floor(x)) & 255;
+    const int32_t Y = static_cast<int32_t>(std::floor(y)) & 255;
+    const int32_t Z = static_cast<int32_t>(std::floor(z)) & 255;
+
+    x -= std::floor(x);
+    y -= std::floor(y);
+    z -= std::floor(z);
+
+    // Rate of change of each weight along its axis, through the fade.
+    T du, dv, dw;
+    const T u = blend(fade(x), du);
+    const T v = blend(fade(y), dv);
+    const T w = blend(fade(z), dw);
+
+    du *= 30 * x * x * (x - 1) * (x - 1);
+    dv *= 30 * y * y * (y - 1) * (y - 1);
+    dw *= 30 * z * z * (z - 1) * (z - 1);
+
+    const auto A = p[X] + Y;
+    const auto AA = p[A] + Z;
+    const auto AB = p[A + 1] + Z;
+    const auto B = p[X + 1] + Y;
+    const auto BA = p[B] + Z;
+    const auto BB = p[B + 1] + Z;
+
+    // Corners in the order x, then y, then z varies. Each corner's value is
+    // linear in the offset, so its own gradient is the value at unit offsets.
+    const int32_t hash[8] = {p[AA], p[BA], p[AB], p[BB], p[AA + 1], p[BA + 1], p[AB + 1], p[BB + 1]};
+    T value[8], dx[8], dy[8], dz[8];
+
+    for (int c = 0; c < 8; ++c) {
+        value[c] = grad(hash[c], x - (c & 1), y - ((c >> 1) & 1), z - (c >> 2));
+        dx[c] = grad(hash[c], T(1), T(0), T(0));
+        dy[c] = grad(hash[c], T(0), T(1), T(0));
+        dz[c] = grad(hash[c], T(0), T(0), T(1));
+    }
+
+    auto trilinear = [&](const T *c) {
+        return mix(w, mix(v, mix(u, c[0], c[1]), mix(u, c[2], c[3])),
+                   mix(v, mix(u, c[4], c[5]), mix(u, c[6], c[7])));
+    };
+
+    // The weights move too: each axis adds the difference across it, mixed
+    // over the other two, times the rate of its weight.
+    const T acrossX = mix(w, mix(v, value[1] - value[0], value[3] - value[2]),
+                          mix(v, value[5] - value[4], value[7] - value[6]));
+    const T acrossY = mix(w, mix(u, value[2] - value[0], value[3] - value[1]),
+                          mix(u, value[6] - value[4], value[7] - value[5]));
+    const T acrossZ = mix(v, mix(u, value[4] - value[0], value[5] - value[1]),
+                          mix(u, value[6] - value[2], value[7] - value[3]));
+
+    gradient[0] = trilinear(dx) + acrossX * du;
+    gradient[1] = trilinear(dy) + acrossY * dv;
+    gradient[2] = trilinear(dz) + acrossZ * dw;
+
+    return trilinear(value);
+}
+
+#if defined(__AVX512F__)
+
+static inline __m512d fade8(__m512d t) {
+    __m512d r = _mm512_fmadd_pd(t, _mm512_set1_pd(6), _mm512_set1_pd(-15));
+    r = _mm512_fmadd_pd(t, r, _mm512_set1_pd(10));
+    return _mm512_mul_pd(_mm512_mul_pd(_mm512_mul_pd(t, t), t), r);
+}
+
+static inline __m512d lookup8(__m512d t) {
+    const __m512d x = _mm512_mul_pd(t, _mm512_set1_pd(blendSteps));
+    const __m512d step = _mm512_min_pd(_mm512_roundscale_pd(x, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC),
+                                       _mm512_set1_pd(blendSteps - 1));
+    const __m256i i = _mm512_cvttpd_epi32(step);
+    const __m512d below = _mm512_i32gather_pd(i, blendTable.data(), 8);
+    const __m512d above = _mm512_i32gather_pd(i, blendTable.data() + 1, 8);
+    return _mm512_fmadd_pd(_mm512_sub_pd(x, step), _mm512_sub_pd(above, below), below);
+}
+
+static inline __m512d blend8(__m512d t, int first) {
+    if (first == blendLookup)
+        return lookup8(t);
+    const __m512d half = _mm512_set1_pd(0.5);
+    const __m512d s = _mm512_mul_pd(_mm512_sub_pd(t, half), _mm512_set1_pd(M_PI));
+    const __m512d q = _mm512_mul_pd(s, s);
+    __m512d poly = _mm512_set1_pd(sinTaylor[first]);
+    for (int i = first + 1; i < 10; ++i)
+        poly = _mm512_fmadd_pd(poly, q, _mm512_set1_pd(sinTaylor[i]));
+    return _mm512_fmadd_pd(_mm512_mul_pd(s, poly), half, half);
+}
+
+static inline __m512d lerp8(__m512d f, __m512d a, __m512d b) {
+    return _mm512_fmadd_pd(f, b, _mm512_mul_pd(_mm512_sub_pd(_mm512_set1_pd(1.0), f), a));
+}
+
+static inline __m256i gather8(const int32_t *p, __m256i index) {
+    return _mm256_i32gather_epi32(p, index, 4);
+}
+
+// grad() without branches: the low four bits of the hash pick the two
+// coordinates with masks and flip their signs directly.
+static inline __m512d grad8(__m256i hash, __m512d x, __m512d y, __m512d z) {
+    const __m512i h = _mm512_cvtepi32_epi64(_mm256_and_si256(hash, _mm256_set1_epi32(15)));
+    const __mmask8 lt8 = _mm512_cmplt_epi64_mask(h, _mm512_set1_epi64(8));
+    const __mmask8 lt4 = _mm512_cmplt_epi64_mask(h, _mm512_set1_epi64(4));
+    const __mmask8 xz = _mm512_cmpeq_epi64_mask(h, _mm512_set1_epi64(12))
+                      | _mm512_cmpeq_epi64_mask(h, _mm512_set1_epi64(14));
+    const __m512d u = _mm512_mask_blend_pd(lt8, y, x);
+    const __m512d v = _mm512_mask_blend_pd(lt4, _mm512_mask_blend_pd(xz, z, x), y);
+    const __m512i su = _mm512_slli_epi64(_mm512_and_si512(h, _mm512_set1_epi64(1)), 63);
+    const __m512i sv = _mm512_slli_epi64(_mm512_and_si512(h, _mm512_set1_epi64(2)), 62);
+    return _mm512_add_pd(_mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(u), su)),
+                         _mm512_castsi512_pd(_mm512_xor_si512(_mm512_castpd_si512(v), sv)));
+}
+
+static const std::size_t vectorBytes = 64;
+
+static void batchKernel(const int32_t *p, int first, const double *px, const double *py,
+                        const double *pz, double *out) {
+    const int rounding = _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC;
+    const __m512d one = _mm512_set1_pd(1.0);
+    const __m256i mask = _mm256_set1_epi32(255), next = _mm256_set1_epi32(1);
+
+    __m512d x = _mm512_loadu_pd(px), y = _mm512_loadu_pd(py), z = _mm512_loadu_pd(pz);
+    const __m512d fx = _mm512_roundscale_pd(x, rounding);
+    const __m512d fy = _mm512_roundscale_pd(y, rounding);
+    const __m512d fz = _mm512_roundscale_pd(z, rounding);
+    const __m256i X = _mm256_and_si256(_mm512_cvttpd_epi32(fx), mask);
+    const __m256i Y = _mm256_and_si256(_mm512_cvttpd_epi32(fy), mask);
+    const __m256i Z = _mm256_and_si256(_mm512_cvttpd_epi32(fz), mask);
+
+    x = _mm512_sub_pd(x, fx);
+    y = _mm512_sub_pd(y, fy);
+    z = _mm512_sub_pd(z, fz);
+
+    const __m512d u = blend8(fade8(x), first), v = blend8(fade8(y), first), w = blend8(fade8(z), first);
+    const __m512d x1 = _mm512_sub_pd(x, one), y1 = _mm512_sub_pd(y, one), z1 = _mm512_sub_pd(z, one);
+
+    const __m256i A = _mm256_add_epi32(gather8(p, X), Y);
+    const __m256i AA = _mm256_add_epi32(gather8(p, A), Z);
+    const __m256i AB = _mm256_add_epi32(gather8(p, _mm256_add_epi32(A, next)), Z);
+    const __m256i B = _mm256_add_epi32(gather8(p, _mm256_add_epi32(X, next)), Y);
+    const __m256i BA = _mm256_add_epi32(gather8(p, B), Z);
+    const __m256i BB = _mm256_add_epi32(gather8(p, _mm256_add_epi32(B, next)), Z);
+
+    const __m512d a = lerp8(v,
+        lerp8(u, grad8(gather8(p, AA), x, y, z), grad8(gather8(p, BA), x1, y, z)),
+        lerp8(u, grad8(gather8(p, AB), x, y1, z), grad8(gather8(p, BB), x1, y1, z))
+    );
+
+    const __m512d b = lerp8(v,
+        lerp8(u, grad8(gather8(p, _mm256_add_epi32(AA, next)), x, y, z1),
+                 grad8(gather8(p, _mm256_add_epi32(BA, next)), x1, y, z1)),
+        lerp8(u, grad8(gather8(p, _mm256_add_epi32(AB, next)), x, y1, z1),
+                 grad8(gather8(p, _mm256_add_epi32(BB, next)), x1, y1, z1))
+    );
+
+    _mm512_storeu_pd(out, lerp8(w, a, b));
+}
+
+// Single precision: sixteen points per vector, and the hashes already sit in
+// lanes of the same width as the coordinates.
+
+static inline __m512 fade16(__m512 t) {
+    __m512 r = _mm512_fmadd_ps(t, _mm512_set1_ps(6), _mm512_set1_ps(-15));
+    r = _mm512_fmadd_ps(t, r, _mm512_set1_ps(10));
+    return _mm512_mul_ps(_mm512_mul_ps(_mm512_mul_ps(t, t), t), r);
+}
+
+static inline __m512 lookup16(__m512 t) {
+    const __m512 x = _mm512_mul_ps(t, _mm512_set1_ps(blendSteps));
+    const __m512 step = _mm512_min_ps(_mm512_roundscale_ps(x, _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC),
+                                      _mm512_set1_ps(blendSteps - 1));
+    const __m512i i = _mm512_cvttps_epi32(step);
+    const __m512 below = _mm512_i32gather_ps(i, blendTableFloat.data(), 4);
+    const __m512 above = _mm512_i32gather_ps(i, blendTableFloat.data() + 1, 4);
+    return _mm512_fmadd_ps(_mm512_sub_ps(x, step), _mm512_sub_ps(above, below), below);
+}
+
+static inline __m512 blend16(__m512 t, int first) {
+    if (first == blendLookup)
+        return lookup16(t);
+    const __m512 half = _mm512_set1_ps(0.5f);
+    const __m512 s = _mm512_mul_ps(_mm512_sub_ps(t, half), _mm512_set1_ps(M_PI));
+    const __m512 q = _mm512_mul_ps(s, s);
+    __m512 poly = _mm512_set1_ps(sinTaylor[first]);
+    for (int i = first + 1; i < 10; ++i)
+        poly = _mm512_fmadd_ps(poly, q, _mm512_set1_ps(sinTaylor[i]));
+    return _mm512_fmadd_ps(_mm512_mul_ps(s, poly), half, half);
+}
+
+static inline __m512 lerp16(__m512 f, __m512 a, __m512 b) {
+    return _mm512_fmadd_ps(f, b, _mm512_mul_ps(_mm512_sub_ps(_mm512_set1_ps(1.0f), f), a));
+}
+
+static inline __m512i gather16(const int32_t *p, __m512i index) {
+    return _mm512_i32gather_epi32(index, p, 4);
+}
+
+static inline __m512 grad16(__m512i hash, __m512 x, __m512 y, __m512 z) {
+    const __m512i h = _mm512_and_si512(hash, _mm512_set1_epi32(15));
+    const __mmask16 lt8 = _mm512_cmplt_epi32_mask(h, _mm512_set1_epi32(8));
+    const __mmask16 lt4 = _mm512_cmplt_epi32_mask(h, _mm512_set1_epi32(4));
+    const __mmask16 xz = _mm512_cmpeq_epi32_mask(h, _mm512_set1_epi32(12))
+                       | _mm512_cmpeq_epi32_mask(h, _mm512_set1_epi32(14));
+    const __m512 u = _mm512_mask_blend_ps(lt8, y, x);
+    const __m512 v = _mm512_mask_blend_ps(lt4, _mm512_mask_blend_ps(xz, z, x), y);
+    const __m512i su = _mm512_slli_epi32(_mm512_and_si512(h, _mm512_set1_epi32(1)), 31);
+    const __m512i sv = _mm512_slli_epi32(_mm512_and_si512(h, _mm512_set1_epi32(2)), 30);
+    return _mm512_add_ps(_mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(u), su)),
+                         _mm512_castsi512_ps(_mm512_xor_si512(_mm512_castps_si512(v), sv)));
+}
+
+static void batchKernel(const int32_t *p, int first, const float *px, const float *py,
+                        const float *pz, float *out) {
+    const int rounding = _MM_FROUND_TO_NEG_INF | _MM_FROUND_NO_EXC;
+    const __m512 one = _mm512_set1_ps(1.0f);
+    const __m512i mask = _mm512_set1_epi32(255), next = _mm512_set1_epi32(1);
+
+    __m512 x = _mm512_loadu_ps(px), y = _mm512_loadu_ps(py), z = _mm512_loadu_ps(pz);
+    const __m512 fx = _mm512_roundscale_ps(x, rounding);
+    const __m512 fy = _mm512_roundscale_ps(y, rounding);
+    const __m512 fz = _mm512_roundscale_ps(z, rounding);
+    const __m512i X = _mm512_and_si512(_mm512_cvttps_epi32(fx), mask);
+    const __m512i Y = _mm512_and_si512(_mm512_cvttps_epi32(fy), mask);
+    const __m512i Z = _mm512_and_si512(_mm512_cvttps_epi32(fz), mask);
+
+    x = _mm512_sub_ps(x, fx);
+    y = _mm512_sub_ps(y, fy);
+    z = _mm512_sub_ps(z, fz);
+
+    const __m512 u = blend16(fade16(x), first), v = blend16(fade16(y), first), w = blend16(fade16(z), first);
+    const __m512 x1 = _mm512_sub_ps(x, one), y1 = _mm512_sub_ps(y, one), z1 = _mm512_sub_ps(z, one);
+
+    const __m512i A = _mm512_add_epi32(gather16(p, X), Y);
+    const __m512i AA = _mm512_add_epi32(gather16(p, A), Z);
+    const __m512i AB = _mm512_add_epi32(gather16(p, _mm512_add_epi32(A, next)), Z);
+    const __m512i B = _mm512_add_epi32(gather16(p, _mm512_add_epi32(X, next)), Y);
+    const __m512i BA = _mm512_add_epi32(gather16(p, B), Z);
+    const __m512i BB = _mm512_add_epi32(gather16(p, _mm512_add_epi32(B, next)), Z);
+
+    const __m512 a = lerp16(v,
+        lerp16(u, grad16(gather16(p, AA), x, y, z), grad16(gather16(p, BA), x1, y, z)),
+        lerp16(u, grad16(gather16(p, AB), x, y1, z), grad16(gather16(p, BB), x1, y1, z))
+    );
+
+    const __m512 b = lerp16(v,
+        lerp16(u, grad16(gather16(p, _mm512_add_epi32(AA, next)), x, y, z1),
+                  grad16(gather16(p, _mm512_add_epi32(BA, next)), x1, y, z1)),
+        lerp16(u, grad16(gather16(p, _mm512_add_epi32(AB, next)), x, y1, z1),
+                  grad16(gather16(p, _mm512_add_epi32(BB, next)), x1, y1, z1))
+    );
+
+    _mm512_storeu_ps(out, lerp16(w, a, b));
+}
+
+#elif defined(__AVX2__)
+
+static inline __m256d fade4(__m256d t) {
+    __m256d r = _mm256_fmadd_pd(t, _mm256_set1_pd(6), _mm256_set1_pd(-15));
+    r = _mm256_fmadd_pd(t, r, _mm256_set1_pd(10));
+    return _mm256_mul_pd(_mm256_mul_pd(_mm256_mul_pd(t, t), t), r);
+}
+
+static inline __m256d lookup4(__m256d t) {
+    const __m256d x = _mm256_mul_pd(t, _mm256_set1_pd(blendSteps));
+    const __m256d step = _mm256_min_pd(_mm256_floor_pd(x), _mm256_set1_pd(blendSteps - 1));
+    const __m128i i = _mm256_cvttpd_epi32(step);
+    const __m256d below = _mm256_i32gather_pd(blendTable.data(), i, 8);
+    const __m256d above = _mm256_i32gather_pd(blendTable.data() + 1, i, 8);
+    return _mm256_fmadd_pd(_mm256_sub_pd(x, step), _mm256_sub_pd(above, below), below);
+}
+
+static inline __m256d blend4(__m256d t, int first) {
+    if (first == blendLookup)
+        return lookup4(t);
+    const __m256d half = _mm256_set1_pd(0.5);
+    const __m256d s = _mm256_mul_pd(_mm256_sub_pd(t, half), _mm256_set1_pd(M_PI));
+    const __m256d q = _mm256_mul_pd(s, s);
+    __m256d poly = _mm256_set1_pd(sinTaylor[first]);
+    for (int i = first + 1; i < 10; ++i)
+        poly = _mm256_fmadd_pd(poly, q, _mm256_set1_pd(sinTaylor[i]));
+    return _mm256_fmadd_pd(_mm256_mul_pd(s, poly), half, half);
+}
+
+static inline __m256d lerp4(__m256d f, __m256d a, __m256d b) {
+    return _mm256_fmadd_pd(f, b, _mm256_mul_pd(_mm256_sub_pd(_mm256_set1_pd(1.0), f), a));
+}
+
+static inline __m128i gather4(const int32_t *p, __m128i index) {
+    return _mm_i32gather_epi32(p, index, 4);
+}
+
+// grad() without branches: the low four bits of the hash pick the two
+// coordinates with masks and flip their signs directly.
+static inline __m256d grad4(__m128i hash, __m256d x, __m256d y, __m256d z) {
+    const __m128i h = _mm_and_si128(hash, _mm_set1_epi32(15));
+    const __m256d lt8 = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm_cmplt_epi32(h, _mm_set1_epi32(8))));
+    const __m256d lt4 = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm_cmplt_epi32(h, _mm_set1_epi32(4))));
+    const __m256d xz = _mm256_castsi256_pd(_mm256_cvtepi32_epi64(_mm_or_si128(
+        _mm_cmpeq_epi32(h, _mm_set1_epi32(12)), _mm_cmpeq_epi32(h, _mm_set1_epi32(14)))));
+    const __m256d u = _mm256_blendv_pd(y, x, lt8);
+    const __m256d v = _mm256_blendv_pd(_mm256_blendv_pd(z, x, xz), y, lt4);
+    const __m256i su = _mm256_slli_epi64(_mm256_cvtepi32_epi64(_mm_and_si128(h, _mm_set1_epi32(1))), 63);
+    const __m256i sv = _mm256_slli_epi64(_mm256_cvtepi32_epi64(_mm_and_si128(h, _mm_set1_epi32(2))), 62);
+    return _mm256_add_pd(_mm256_xor_pd(u, _mm256_castsi256_pd(su)),
+                         _mm256_xor_pd(v, _mm256_castsi256_pd(sv)));
+}
+
+static const std::size_t vectorBytes = 32;
+
+static void batchKernel(const int32_t *p, int first, const double *px, const double *py,
+                        const double *pz, double *out) {
+    const __m256d one = _mm256_set1_pd(1.0);
+    const __m128i mask = _mm_set1_epi32(255), next = _mm_set1_epi32(1);
+
+    __m256d x = _mm256_loadu_pd(px), y = _mm256_loadu_pd(py), z = _mm256_loadu_pd(pz);
+    const __m256d fx = _mm256_floor_pd(x), fy = _mm256_floor_pd(y), fz = _mm256_floor_pd(z);
+    const __m128i X = _mm_and_si128(_mm256_cvttpd_epi32(fx), mask);
+    const __m128i Y = _mm_and_si128(_mm256_cvttpd_epi32(fy), mask);
+    const __m128i Z = _mm_and_si128(_mm256_cvttpd_epi32(fz), mask);
+
+    x = _mm256_sub_pd(x, fx);
+    y = _mm256_sub_pd(y, fy);
+    z = _mm256_sub_pd(z, fz);
+
+    const __m256d u = blend4(fade4(x), first), v = blend4(fade4(y), first), w = blend4(fade4(z), first);
+    const __m256d x1 = _mm256_sub_pd(x, one), y1 = _mm256_sub_pd(y, one), z1 = _mm256_sub_pd(z, one);
+
+    const __m128i A = _mm_add_epi32(gather4(p, X), Y);
+    const __m128i AA = _mm_add_epi32(gather4(p, A), Z);
+    const __m128i AB = _mm_add_epi32(gather4(p, _mm_add_epi32(A, next)), Z);
+    const __m128i B = _mm_add_epi32(gather4(p, _mm_add_epi32(X, next)), Y);
+    const __m128i BA = _mm_add_epi32(gather4(p, B), Z);
+    const __m128i BB = _mm_add_epi32(gather4(p, _mm_add_epi32(B, next)), Z);
+
+    const __m256d a = lerp4(v,
+        lerp4(u, grad4(gather4(p, AA), x, y, z), grad4(gather4(p, BA), x1, y, z)),
+        lerp4(u, grad4(gather4(p, AB), x, y1, z), grad4(gather4(p, BB), x1, y1, z))
     );
 
-    const auto b = lerp(v,
-        lerp(u, grad(PAA1, x, y, z-1), grad(PBA1, x-1, y, z-1)),
-        lerp(u, grad(PAB1, x, y-1, z-1), grad(PBB1, x-1, y-1, z-1))
+    const __m256d b = lerp4(v,
+        lerp4(u, grad4(gather4(p, _mm_add_epi32(AA, next)), x, y, z1),
+                 grad4(gather4(p, _mm_add_epi32(BA, next)), x1, y, z1)),
+        lerp4(u, grad4(gather4(p, _mm_add_epi32(AB, next)), x, y1, z1),
+                 grad4(gather4(p, _mm_add_epi32(BB, next)), x1, y1, z1))
     );
 
-    return lerp(w, a, b);
+    _mm256_storeu_pd(out, lerp4(w, a, b));
+}
+
+// Single precision: eight points per vector, and the hashes already sit in
+// lanes of the same width as the coordinates.
+
+static inline __m256 fade8f(__m256 t) {
+    __m256 r = _mm256_fmadd_ps(t, _mm256_set1_ps(6), _mm256_set1_ps(-15));
+    r = _mm256_fmadd_ps(t, r, _mm256_set1_ps(10));
+    return _mm256_mul_ps(_mm256_mul_ps(_mm256_mul_ps(t, t), t), r);
+}
+
+static inline __m256 lookup8f(__m256 t) {
+    const __m256 x = _mm256_mul_ps(t, _mm256_set1_ps(blendSteps));
+    const __m256 step = _mm256_min_ps(_mm256_floor_ps(x), _mm256_set1_ps(blendSteps - 1));
+    const __m256i i = _mm256_cvttps_epi32(step);
+    const __m256 below = _mm256_i32gather_ps(blendTableFloat.data(), i, 4);
+    const __m256 above = _mm256_i32gather_ps(blendTableFloat.data() + 1, i, 4);
+    return _mm256_fmadd_ps(_mm256_sub_ps(x, step), _mm256_sub_ps(above, below), below);
+}
+
+static inline __m256 blend8f(__m256 t, int first) {
+    if (first == blendLookup)
+        return lookup8f(t);
+    const __m256 half = _mm256_set1_ps(0.5f);
+    const __m256 s = _mm256_mul_ps(_mm256_sub_ps(t, half), _mm256_set1_ps(M_PI));
+    const __m256 q = _mm256_mul_ps(s, s);
+    __m256 poly = _mm256_set1_ps(sinTaylor[first]);
+    for (int i = first + 1; i < 10; ++i)
+        poly = _mm256_fmadd_ps(poly, q, _mm256_set1_ps(sinTaylor[i]));
+    return _mm256_fmadd_ps(_mm256_mul_ps(s, poly), half, half);
+}
+
+static inline __m256 lerp8f(__m256 f, __m256 a, __m256 b) {
+    return _mm256_fmadd_ps(f, b, _mm256_mul_ps(_mm256_sub_ps(_mm256_set1_ps(1.0f), f), a));
+}
+
+static inline __m256i gather8f(const int32_t *p, __m256i index) {
+    return _mm256_i32gather_epi32(p, index, 4);
+}
+
+static inline __m256 grad8f(__m256i hash, __m256 x, __m256 y, __m256 z) {
+    const __m256i h = _mm256_and_si256(hash, _mm256_set1_epi32(15));
+    const __m256 lt8 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(8), h));
+    const __m256 lt4 = _mm256_castsi256_ps(_mm256_cmpgt_epi32(_mm256_set1_epi32(4), h));
+    const __m256 xz = _mm256_castsi256_ps(_mm256_or_si256(
+        _mm256_cmpeq_epi32(h, _mm256_set1_epi32(12)), _mm256_cmpeq_epi32(h, _mm256_set1_epi32(14))));
+    const __m256 u = _mm256_blendv_ps(y, x, lt8);
+    const __m256 v = _mm256_blendv_ps(_mm256_blendv_ps(z, x, xz), y, lt4);
+    const __m256i su = _mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(1)), 31);
+    const __m256i sv = _mm256_slli_epi32(_mm256_and_si256(h, _mm256_set1_epi32(2)), 30);
+    return _mm256_add_ps(_mm256_xor_ps(u, _mm256_castsi256_ps(su)),
+                         _mm256_xor_ps(v, _mm256_castsi256_ps(sv)));
+}
+
+static void batchKernel(const int32_t *p, int first, const float *px, const float *py,
+                        const float *pz, float *out) {
+    const __m256 one = _mm256_set1_ps(1.0f);
+    const __m256i mask = _mm256_set1_epi32(255), next = _mm256_set1_epi32(1);
+
+    __m256 x = _mm256_loadu_ps(px), y = _mm256_loadu_ps(py), z = _mm256_loadu_ps(pz);
+    const __m256 fx = _mm256_floor_ps(x), fy = _mm256_floor_ps(y), fz = _mm256_floor_ps(z);
+    const __m256i X = _mm256_and_si256(_mm256_cvttps_epi32(fx), mask);
+    const __m256i Y = _mm256_and_si256(_mm256_cvttps_epi32(fy), mask);
+    const __m256i Z = _mm256_and_si256(_mm256_cvttps_epi32(fz), mask);
+
+    x = _mm256_sub_ps(x, fx);
+    y = _mm256_sub_ps(y, fy);
+    z = _mm256_sub_ps(z, fz);
+
+    const __m256 u = blend8f(fade8f(x), first), v = blend8f(fade8f(y), first), w = blend8f(fade8f(z), first);
+    const __m256 x1 = _mm256_sub_ps(x, one), y1 = _mm256_sub_ps(y, one), z1 = _mm256_sub_ps(z, one);
+
+    const __m256i A = _mm256_add_epi32(gather8f(p, X), Y);
+    const __m256i AA = _mm256_add_epi32(gather8f(p, A), Z);
+    const __m256i AB = _mm256_add_epi32(gather8f(p, _mm256_add_epi32(A, next)), Z);
+    const __m256i B = _mm256_add_epi32(gather8f(p, _mm256_add_epi32(X, next)), Y);
+    const __m256i BA = _mm256_add_epi32(gather8f(p, B), Z);
+    const __m256i BB = _mm256_add_epi32(gather8f(p, _mm256_add_epi32(B, next)), Z);
+
+    const __m256 a = lerp8f(v,
+        lerp8f(u, grad8f(gather8f(p, AA), x, y, z), grad8f(gather8f(p, BA), x1, y, z)),
+        lerp8f(u, grad8f(gather8f(p, AB), x, y1, z), grad8f(gather8f(p, BB), x1, y1, z))
+    );
+
+    const __m256 b = lerp8f(v,
+        lerp8f(u, grad8f(gather8f(p, _mm256_add_epi32(AA, next)), x, y, z1),
+                  grad8f(gather8f(p, _mm256_add_epi32(BA, next)), x1, y, z1)),
+        lerp8f(u, grad8f(gather8f(p, _mm256_add_epi32(AB, next)), x, y1, z1),
+                  grad8f(gather8f(p, _mm256_add_epi32(BB, next)), x1, y1, z1))
+    );
+
+    _mm256_storeu_ps(out, lerp8f(w, a, b));
+}
+
+#endif
+
+#if defined(__AVX2__)
+
+// Runs the kernel for T over a batch, one vector register of points at a
+// time, with the sine series from the given term or the table.
+template<typename T>
+static void batch(const int32_t *p, int first, const T *x, const T *y, const T *z, T *out,
+                  std::size_t n) {
+    const std::size_t width = vectorBytes / sizeof(T);
+    std::size_t i = 0;
+
+    for (; i + width <= n; i += width)
+        batchKernel(p, first, x + i, y + i, z + i, out + i);
+
+    // Pad the tail out to a whole vector so every point takes the same path
+    // wherever the batch happens to end.
+    if (i < n) {
+        T tx[width] = {}, ty[width] = {}, tz[width] = {}, to[width];
+        std::copy(x + i, x + n, tx);
+        std::copy(y + i, y + n, ty);
+        std::copy(z + i, z + n, tz);
+        batchKernel(p, first, tx, ty, tz, to);
+        std::copy(to, to + (n - i), out + i);
+    }
+}
+
+#endif
+
+template<typename T>
+void Perlin<T>::noise(const T *x, const T *y, const T *z, T *out, std::size_t n) const {
+#if defined(__AVX2__)
+    // The cosine comes from the whole series, which is good to a couple of
+    // ulps, as the kernels have no vector cosine to call.
+    const int exact = sizeof(T) == sizeof(float) ? sinTaylorFloat : 0;
+    const int first = blend_ == Blend::cosine ? exact :
+                      blend_ == Blend::polynomial ? sinTaylorShort : blendLookup;
+    batch(p.data(), first, x, y, z, out, n);
+#else
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = noise(x[i], y[i], z[i]);
+#endif
+}
+
+template<typename T>
+Simplex<T>::Simplex(uint32_t seed, Blend): p(permutation(seed)) {}
+
+template<typename T>
+T Simplex<T>::noise(T x, T y, T z) const {
+    return noise(x, y, z, nullptr);
+}
+
+template<typename T>
+T Simplex<T>::noise(T x, T y, T z, T *gradient) const {
+    //See here for algorithm: http://staffwww.itn.liu.se/~stegu/simplexnoise/simplexnoise.pdf
+    static const T F3 = T(1) / 3;
+    static const T G3 = T(1) / 6;
+    static const int edges[12][3] = {
+        {1,1,0}, {-1,1,0}, {1,-1,0}, {-1,-1,0},
+        {1,0,1}, {-1,0,1}, {1,0,-1}, {-1,0,-1},
+        {0,1,1}, {0,-1,1}, {0,1,-1}, {0,-1,-1}
+    };
+
+    // Skew into the cube lattice to find the simplex cell.
+    const T s = (x + y + z) * F3;
+    const T i = std::floor(x + s);
+    const T j = std::floor(y + s);
+    const T k = std::floor(z + s);
+    const T t = (i + j + k) * G3;
+
+    T dx[4], dy[4], dz[4];
+    dx[0] = x - (i - t);
+    dy[0] = y - (j - t);
+    dz[0] = z - (k - t);
+
+    // The two middle corners step along the axes in order of the offsets.
+    int i1, j1, k1, i2, j2, k2;
+    if(dx[0] >= dy[0]) {
+        if(dy[0] >= dz[0])      { i1=1; j1=0; k1=0; i2=1; j2=1; k2=0; }
+        else if(dx[0] >= dz[0]) { i1=1; j1=0; k1=0; i2=1; j2=0; k2=1; }
+        else                    { i1=0; j1=0; k1=1; i2=1; j2=0; k2=1; }
+    } else {
+        if(dy[0] < dz[0])       { i1=0; j1=0; k1=1; i2=0; j2=1; k2=1; }
+        else if(dx[0] < dz[0])  { i1=0; j1=1; k1=0; i2=0; j2=1; k2=1; }
+        else                    { i1=0; j1=1; k1=0; i2=1; j2=1; k2=0; }
+    }
+
+    const int corner[4][3] = {{0,0,0}, {i1,j1,k1}, {i2,j2,k2}, {1,1,1}};
+    const int32_t ii = static_cast<int32_t>(i) & 255;
+    const int32_t jj = static_cast<int32_t>(j) & 255;
+    const int32_t kk = static_cast<int32_t>(k) & 255;
+
+    T result = 0;
+
+    if(gradient) {
+        gradient[0] = gradient[1] = gradient[2] = 0;
+    }
+
+    for(int c = 0; c < 4; ++c) {
+        if(c > 0) {
+            dx[c] = dx[0] - corner[c][0] + c * G3;
+            dy[c] = dy[0] - corner[c][1] + c * G3;
+            dz[c] = dz[0] - corner[c][2] + c * G3;
+        }
+
+        T falloff = T(0.6) - dx[c] * dx[c] - dy[c] * dy[c] - dz[c] * dz[c];
+        if(falloff <= 0) {
+            continue;
+        }
+
+        const int *g = edges[p[ii + corner[c][0] + p[jj + corner[c][1] + p[kk + corner[c][2]]]] % 12];
+        const T squared = falloff * falloff;
+        const T dot = g[0] * dx[c] + g[1] * dy[c] + g[2] * dz[c];
+        result += squared * squared * dot;
+
+        // The corner adds falloff^4 g.d, whose gradient is falloff^4 g less
+        // 8 falloff^3 (g.d) d.
+        if(gradient) {
+            const T along = 8 * squared * falloff * dot;
+            gradient[0] += squared * squared * g[0] - along * dx[c];
+            gradient[1] += squared * squared * g[1] - along * dy[c];
+            gradient[2] += squared * squared * g[2] - along * dz[c];
+        }
+    }
+
+    if(gradient) {
+        gradient[0] *= 32;
+        gradient[1] *= 32;
+        gradient[2] *= 32;
+    }
+
+    // Scales the result to about [-1, 1].
+    return 32 * result;
 }
 
-PerlinOctave::PerlinOctave(int octaves, double lacuna, uint32_t seed):
-    perlin_(seed),
+template<typename T>
+void Simplex<T>::noise(const T *x, const T *y, const T *z, T *out, std::size_t n) const {
+    for (std::size_t i = 0; i < n; ++i)
+        out[i] = noise(x[i], y[i], z[i]);
+}
+
+template<class Basis>
+Octave<Basis>::Octave(int octaves, double lacuna, uint32_t seed, Blend blend):
+    basis_(seed, blend),
 	lacuna_(lacuna),
     octaves_(octaves)
 {}
 
-double PerlinOctave::noise(double x, double y, double z, double persist) const {
-    double result = 0.0;
-    double amp = 1.0;
+template<class Basis>
+typename Octave<Basis>::value_type Octave<Basis>::noise(value_type x, value_type y, value_type z, value_type persist) const {
+    value_type result = 0;
+    value_type amp = 1;
 
     int i = octaves_;
     while(i--) {
-        result += perlin_.noise(x, y, z) * amp;
+        result += basis_.noise(x, y, z) * amp;
         x *= lacuna_;
         y *= lacuna_;
         z *= lacuna_;
@@ -121,24 +829,273 @@ double PerlinOctave::noise(double x, double y, double z, double persist) const {
     return result;
 }
 
-double PerlinOctave::ridge(double x, double y, double z) const {
-	double result = 0.0;
-	double amp = 1.0;
-	double freq = 1.0;
+template<class Basis>
+typename Octave<Basis>::value_type Octave<Basis>::ridge(value_type x, value_type y, value_type z) const {
+	value_type result = 0;
+	value_type amp = 1;
+	value_type freq = 1;
 
 	int i = octaves_;
 	while(i--) {
-		double signal = 1.0 - std::abs(perlin_.noise(x, y, z));
+		value_type signal = 1 - std::abs(basis_.noise(x, y, z));
 		signal *= signal * amp;
 		freq *= lacuna_;
 		x *= lacuna_;
 		y *= lacuna_;
 		z *= lacuna_;
 		result += signal / freq;
-		amp = std::max(std::min(signal * 2.0, 1.0), 0.0);
+		amp = std::max(std::min(signal * 2, value_type(1)), value_type(0));
+	}
+
+	return (result * 2) - 1;
+}
+
+template<class Basis>
+typename Octave<Basis>::value_type Octave<Basis>::noise(value_type x, value_type y, value_type z, value_type persist,
+                                                        value_type *gradient) const {
+    value_type fbm, ridged;
+    fused(x, y, z, persist, fbm, gradient, ridged, nullptr);
+    return fbm;
+}
+
+template<class Basis>
+typename Octave<Basis>::value_type Octave<Basis>::ridge(value_type x, value_type y, value_type z,
+                                                        value_type *gradient) const {
+    value_type fbm, ridged;
+    fused(x, y, z, 1, fbm, nullptr, ridged, gradient);
+    return ridged;
+}
+
+template<class Basis>
+void Octave<Basis>::fused(value_type x, value_type y, value_type z, value_type persist,
+                          value_type &fbm, value_type *fbmGradient,
+                          value_type &ridged, value_type *ridgedGradient) const {
+	value_type fbmAmp = 1;
+	value_type amp = 1;
+	value_type freq = 1;
+	value_type part[3], dAmp[3] = {0, 0, 0};
+	value_type dFbm[3] = {0, 0, 0}, dRidged[3] = {0, 0, 0};
+
+	fbm = ridged = 0;
+
+	// Each octave's coordinates are scaled by freq, which scales its
+	// gradient too. Ridges are weighted by the octave before, so the
+	// weight's gradient carries on from one octave to the next until the
+	// weight is clamped.
+	int i = octaves_;
+	while(i--) {
+		const value_type n = basis_.noise(x, y, z, part);
+		const value_type crest = 1 - std::abs(n);
+		const value_type sign = n < 0 ? 1 : -1;
+		value_type signal = crest * (crest * amp);
+		value_type dSignal[3];
+		for (int d = 0; d < 3; ++d) {
+			dFbm[d] += part[d] * fbmAmp * freq;
+			dSignal[d] = 2 * crest * sign * part[d] * freq * amp + crest * crest * dAmp[d];
+		}
+		fbm += n * fbmAmp;
+		fbmAmp *= persist;
+		freq *= lacuna_;
+		x *= lacuna_;
+		y *= lacuna_;
+		z *= lacuna_;
+		ridged += signal / freq;
+		const bool clamped = signal * 2 <= 0 || signal * 2 >= 1;
+		for (int d = 0; d < 3; ++d) {
+			dRidged[d] += dSignal[d] / freq;
+			dAmp[d] = clamped ? 0 : dSignal[d] * 2;
+		}
+		amp = std::max(std::min(signal * 2, value_type(1)), value_type(0));
+	}
+
+	ridged = (ridged * 2) - 1;
+
+	for (int d = 0; d < 3; ++d) {
+		if (fbmGradient)
+			fbmGradient[d] = dFbm[d];
+		if (ridgedGradient)
+			ridgedGradient[d] = dRidged[d] * 2;
 	}
+}
+
+// Batches go through in chunks small enough that the scaled coordinates
+// stay in cache across octaves.
+static const std::size_t octaveChunk = 256;
+
+template<class Basis>
+void Octave<Basis>::noise(const value_type *x, const value_type *y, const value_type *z,
+                         value_type *out, std::size_t n, value_type persist) const {
+    noise(x, y, z, out, n, persist, 0, octaves_);
+}
+
+template<class Basis>
+void Octave<Basis>::noise(const value_type *x, const value_type *y, const value_type *z,
+                         value_type *out, std::size_t n, value_type persist,
+                         int first, int last) const {
+    value_type sx[octaveChunk], sy[octaveChunk], sz[octaveChunk], part[octaveChunk];
+    value_type skipped = 1;
+
+    for (int i = 0; i < first; ++i)
+        skipped *= persist;
+
+    for (std::size_t begin = 0; begin < n; begin += octaveChunk) {
+        const std::size_t count = std::min(octaveChunk, n - begin);
+        value_type *result = out + begin;
+        value_type amp = skipped;
+
+        for (std::size_t j = 0; j < count; ++j) {
+            sx[j] = x[begin + j];
+            sy[j] = y[begin + j];
+            sz[j] = z[begin + j];
+
+            for (int i = 0; i < first; ++i) {
+                sx[j] *= lacuna_;
+                sy[j] *= lacuna_;
+                sz[j] *= lacuna_;
+            }
+        }
 
-	return (result * 2.0) - 1.0;
+        std::fill(result, result + count, value_type(0));
+
+        int i = last - first;
+        while(i--) {
+            basis_.noise(sx, sy, sz, part, count);
+
+            for (std::size_t j = 0; j < count; ++j) {
+                result[j] += part[j] * amp;
+                sx[j] *= lacuna_;
+                sy[j] *= lacuna_;
+                sz[j] *= lacuna_;
+            }
+
+            amp *= persist;
+        }
+    }
+}
+
+template<class Basis>
+void Octave<Basis>::ridge(const value_type *x, const value_type *y, const value_type *z,
+                         value_type *out, std::size_t n) const {
+    value_type sx[octaveChunk], sy[octaveChunk], sz[octaveChunk], part[octaveChunk];
+    value_type amp[octaveChunk];
+
+    for (std::size_t begin = 0; begin < n; begin += octaveChunk) {
+        const std::size_t count = std::min(octaveChunk, n - begin);
+        value_type *result = out + begin;
+        value_type freq = 1;
+
+        std::copy(x + begin, x + begin + count, sx);
+        std::copy(y + begin, y + begin + count, sy);
+        std::copy(z + begin, z + begin + count, sz);
+        std::fill(result, result + count, value_type(0));
+        std::fill(amp, amp + count, value_type(1));
+
+        int i = octaves_;
+        while(i--) {
+            basis_.noise(sx, sy, sz, part, count);
+            freq *= lacuna_;
+
+            for (std::size_t j = 0; j < count; ++j) {
+                value_type signal = 1 - std::abs(part[j]);
+                signal *= signal * amp[j];
+                sx[j] *= lacuna_;
+                sy[j] *= lacuna_;
+                sz[j] *= lacuna_;
+                result[j] += signal / freq;
+                amp[j] = std::max(std::min(signal * 2, value_type(1)), value_type(0));
+            }
+        }
+
+        for (std::size_t j = 0; j < count; ++j)
+            result[j] = (result[j] * 2) - 1;
+    }
+}
+
+template<class Basis>
+void Octave<Basis>::fused(const value_type *x, const value_type *y, const value_type *z,
+                          value_type *fbm, value_type *ridged, std::size_t n, value_type persist,
+                          const Octave *second, value_type *secondRidged) const {
+    value_type sx[octaveChunk], sy[octaveChunk], sz[octaveChunk], part[octaveChunk];
+    value_type amp[octaveChunk], secondAmp[octaveChunk];
+    const bool own = fbm || ridged;
+    const int octaves = std::max(own ? octaves_ : 0, second ? second->octaves_ : 0);
+
+    assert(!second || (secondRidged && second->lacuna_ == lacuna_));
+
+    for (std::size_t begin = 0; begin < n; begin += octaveChunk) {
+        const std::size_t count = std::min(octaveChunk, n - begin);
+        value_type fbmAmp = 1;
+        value_type freq = 1;
+
+        std::copy(x + begin, x + begin + count, sx);
+        std::copy(y + begin, y + begin + count, sy);
+        std::copy(z + begin, z + begin + count, sz);
+        std::fill(amp, amp + count, value_type(1));
+        std::fill(secondAmp, secondAmp + count, value_type(1));
+
+        if (fbm)
+            std::fill(fbm + begin, fbm + begin + count, value_type(0));
+        if (ridged)
+            std::fill(ridged + begin, ridged + begin + count, value_type(0));
+        if (second)
+            std::fill(secondRidged + begin, secondRidged + begin + count, value_type(0));
+
+        for (int o = 0; o < octaves; ++o) {
+            freq *= lacuna_;
+
+            if (own && o < octaves_) {
+                basis_.noise(sx, sy, sz, part, count);
+
+                for (std::size_t j = 0; j < count; ++j) {
+                    if (fbm)
+                        fbm[begin + j] += part[j] * fbmAmp;
+
+                    if (ridged) {
+                        value_type signal = 1 - std::abs(part[j]);
+                        signal *= signal * amp[j];
+                        ridged[begin + j] += signal / freq;
+                        amp[j] = std::max(std::min(signal * 2, value_type(1)), value_type(0));
+                    }
+                }
+
+                fbmAmp *= persist;
+            }
+
+            if (second && o < second->octaves_) {
+                second->basis_.noise(sx, sy, sz, part, count);
+
+                for (std::size_t j = 0; j < count; ++j) {
+                    value_type signal = 1 - std::abs(part[j]);
+                    signal *= signal * secondAmp[j];
+                    secondRidged[begin + j] += signal / freq;
+                    secondAmp[j] = std::max(std::min(signal * 2, value_type(1)), value_type(0));
+                }
+            }
+
+            for (std::size_t j = 0; j < count; ++j) {
+                sx[j] *= lacuna_;
+                sy[j] *= lacuna_;
+                sz[j] *= lacuna_;
+            }
+        }
+
+        for (std::size_t j = 0; j < count; ++j) {
+            if (ridged)
+                ridged[begin + j] = (ridged[begin + j] * 2) - 1;
+            if (second)
+                secondRidged[begin + j] = (secondRidged[begin + j] * 2) - 1;
+        }
+    }
 }
 
+template class Perlin<float>;
+template class Perlin<double>;
+template class Simplex<float>;
+template class Simplex<double>;
+
+template class Octave<Perlin<float>>;
+template class Octave<Perlin<double>>;
+template class Octave<Simplex<float>>;
+template class Octave<Simplex<double>>;
+
 }
@@ -0,0 +1,177 @@
+#ifndef MULTIGRID_HPP
+#define MULTIGRID_HPP
+
+// ZaWarudo Headers
+#include "geodesic.hpp"
+
+// Utility Headers
+#include "parallel.hpp"
+#include "lib/noise.h"
+
+// C++ STL
+#include <algorithm>
+#include <cmath>
+#include <vector>
+
+namespace zw
+{
+	namespace multigrid
+	{
+		// Levels below this have too few cells to trust the error check.
+		const int coarsest = 4;
+		
+		//
+		// fBm of every cell of a grid subdivided the given number of times,
+		// to within tolerance. Each octave is evaluated only down to the
+		// coarsest level that keeps it within its share of the tolerance, and
+		// filled in on finer levels from the two cells each cell was made
+		// between. Tolerance an octave doesn't use passes on to the next.
+		// Returns the level each octave was evaluated on.
+		//
+		template<class Basis>
+		std::vector<int> fbm( const noise::Octave<Basis> &stack, const double persistence,
+		                      const double tolerance, const geoData::geo_ptr &geodesic,
+		                      const int iterations, std::vector<typename Basis::value_type> &out )
+		{
+			typedef typename Basis::value_type T;
+			
+			const cell_size_t size = cellsPerIteration( iterations );
+			const auto parents = geoData::parents( geodesic, iterations );
+			double budget = tolerance;
+			
+			std::vector<T> octave;
+			std::vector<int> levels;
+			int level = std::min( coarsest, iterations );
+			int filled = level;
+			out.assign( size, 0 );
+			
+			// Octaves [lowest, highest) on cells [first, last), kept in octave
+			// or, when the sum is final up to them, added straight into it.
+			auto evaluate = [&]( const int lowest, const int highest, const cell_size_t first,
+			                     const cell_size_t last, const bool accumulate )
+			{
+				if ( !accumulate && octave.size() < last )
+					octave.resize( last );
+					
+				parallel::spans( last - first, [&]( unsigned, cell_size_t begin, cell_size_t end )
+				{
+					const cell_size_t batch = 4096;
+					std::vector<T> x( batch ), y( batch ), z( batch ), sum( batch );
+					
+					for ( cell_size_t at = first + begin; at < first + end; at += batch )
+					{
+						cell_size_t count = std::min( batch, first + end - at );
+						T *result = accumulate ? sum.data() : &octave[at];
+						
+						for ( cell_size_t i = 0; i < count; ++i )
+						{
+							x[i] = geodesic[at + i].v.x;
+							y[i] = geodesic[at + i].v.y;
+							z[i] = geodesic[at + i].v.z;
+						}
+						
+						stack.noise( x.data(), y.data(), z.data(), result, count, persistence, lowest,
+						             highest );
+						             
+						if ( accumulate )
+							for ( cell_size_t i = 0; i < count; ++i )
+								out[at + i] += sum[i];
+					}
+				} );
+			};
+			
+			// Midpoint of the two cells a cell was made between.
+			auto midpoint = [&]( const std::vector<T> &values, const cell_size_t c )
+			{
+				return ( values[parents[c].first] + values[parents[c].second] ) / 2;
+			};
+			
+			// Filling in is linear, so the sum is filled in once a level for
+			// every octave that stopped short of it rather than per octave.
+			auto fill = [&]( const int upto )
+			{
+				for ( ; filled < upto; ++filled )
+				{
+					const cell_size_t first = cellsPerIteration( filled );
+					
+					parallel::spans( cellsPerIteration( filled + 1 ) - first, [&]( unsigned,
+					                 cell_size_t begin, cell_size_t end )
+					{
+						for ( cell_size_t c = first + begin; c < first + end; ++c )
+							out[c] = midpoint( out, c );
+					} );
+				}
+			};
+			
+			auto add = [&]( const cell_size_t last )
+			{
+				parallel::spans( last, [&]( unsigned, cell_size_t begin, cell_size_t end )
+				{
+					for ( cell_size_t c = begin; c < end; ++c )
+						out[c] += octave[c];
+				} );
+			};
+			
+			int index = 0;
+			
+			for ( ; index < stack.octaves() && level + 1 < iterations; ++index )
+			{
+				evaluate( index, index + 1, 0, cellsPerIteration( level ), false );
+				
+				// Refine until the cells of the next level sit close enough to
+				// the midpoints of their parents. Filling in from the finer
+				// level halves the spacing, which quarters the error, and
+				// filling the inside of a triangle adds at most a third to
+				// that. Octaves only get finer, so the next one starts where
+				// this one stopped.
+				
+				const double share = budget / ( stack.octaves() - index );
+				double error = 0;
+				bool settled = false;
+				
+				while ( !settled && level + 1 < iterations )
+				{
+					const cell_size_t first = cellsPerIteration( level );
+					const cell_size_t last = cellsPerIteration( level + 1 );
+					std::vector<T> worst( parallel::workers( last - first ), 0 );
+					
+					evaluate( index, index + 1, first, last, false );
+					parallel::spans( last - first, [&]( unsigned w, cell_size_t begin, cell_size_t end )
+					{
+						for ( cell_size_t c = first + begin; c < first + end; ++c )
+							worst[w] = std::max( worst[w], std::abs( octave[c] - midpoint( octave, c ) ) );
+					} );
+					
+					++level;
+					error = *std::max_element( worst.begin(), worst.end() ) / 3;
+					settled = error <= share;
+				}
+				
+				if ( !settled )
+					break;
+					
+				budget -= error;
+				levels.push_back( level );
+				fill( level );
+				add( cellsPerIteration( level ) );
+			}
+			
+			// Octaves that need every cell go in a single pass. Checking them
+			// on the finest level would save nothing, since by then they'd
+			// have been evaluated on every cell.
+			
+			fill( iterations );
+			
+			if ( index < stack.octaves() )
+			{
+				evaluate( index, stack.octaves(), 0, size, true );
+				levels.resize( stack.octaves(), iterations );
+			}
+			
+			return levels;
+		}
+	}
+}
+
+#endif
+
@@ -0,0 +1,157 @@
+#ifndef PARALLEL_HPP
+#define PARALLEL_HPP
+
+#include "config.hpp"
+
+// C++ STL
+#include <algorithm>
+#include <atomic>
+#include <thread>
+
+namespace zw
+{
+	namespace parallel
+	{
+		// Grids smaller than this per worker aren't worth a thread.
+		const cell_size_t minimumSpan = 4096;
+		
+		inline unsigned &threadSetting()
+		{
+			static unsigned setting = 0;
+			return setting;
+		}
+		
+		// Set while running inside a worker so nested passes stay serial.
+		inline bool &insideWorker()
+		{
+			static thread_local bool inside = false;
+			return inside;
+		}
+		
+		inline unsigned threads()
+		{
+			if ( threadSetting() > 0 )
+				return threadSetting();
+				
+			unsigned hardware = std::thread::hardware_concurrency();
+			return hardware > 0 ? hardware : 1;
+		}
+		
+		inline void threads( const unsigned count )
+		{
+			threadSetting() = count;
+		}
+		
+		// Number of spans a pass over [0, size) will be split into. Callers
+		// use this to size their per-worker partial results.
+		inline unsigned workers( const cell_size_t size )
+		{
+			if ( insideWorker() )
+				return 1;
+				
+			cell_size_t useful = size / minimumSpan;
+			unsigned count = threads();
+			
+			if ( useful < count )
+				count = useful > 0 ? unsigned( useful ) : 1;
+				
+			return count;
+		}
+		
+		// Calls fn( worker, begin, end ) once per contiguous span of
+		// [0, size), one span per worker. The last span runs on the calling
+		// thread.
+		template<class F>
+		void spans( const cell_size_t size, F fn )
+		{
+			unsigned count = workers( size );
+			
+			if ( count == 1 )
+			{
+				fn( 0u, cell_size_t( 0 ), size );
+				return;
+			}
+			
+			std::vector<std::thread> pool;
+			pool.reserve( count - 1 );
+			
+			for ( unsigned w = 0; w < count; ++w )
+			{
+				cell_size_t begin = std::uint_fast64_t( size ) * w / count;
+				cell_size_t end = std::uint_fast64_t( size ) * ( w + 1 ) / count;
+				auto work = [&fn, w, begin, end]()
+				{
+					insideWorker() = true;
+					fn( w, begin, end );
+					insideWorker() = false;
+				};
+				
+				if ( w + 1 < count )
+					pool.push_back( std::thread( work ) );
+				else
+					work();
+			}
+			
+			for ( auto &t : pool )
+				t.join();
+		}
+		
+		// Calls fn( task ) for each of count independent tasks. With at least
+		// one task per thread, every thread takes the next task as it finishes
+		// one and passes inside tasks stay serial. With fewer, tasks run one
+		// after another and each can spread its own passes over every thread.
+		template<class F>
+		void tasks( const std::size_t count, F fn )
+		{
+			unsigned threadCount = threads();
+			
+			if ( insideWorker() || count < threadCount || threadCount == 1 )
+			{
+				for ( std::size_t task = 0; task < count; ++task )
+					fn( task );
+					
+				return;
+			}
+			
+			std::atomic<std::size_t> next( 0 );
+			std::vector<std::thread> pool;
+			pool.reserve( threadCount - 1 );
+			
+			auto work = [&]()
+			{
+				insideWorker() = true;
+				
+				for ( std::size_t task = next++; task < count; task = next++ )
+					fn( task );
+					
+				insideWorker() = false;
+			};
+			
+			for ( unsigned w = 0; w + 1 < threadCount; ++w )
+				pool.push_back( std::thread( work ) );
+				
+			work();
+			
+			for ( auto &t : pool )
+				t.join();
+		}
+		
+		// Calls fn( worker, begin, end ) for each block of [0, size) in turn.
+		// Blocks are a fixed size and a worker takes whichever start in its
+		// span, so they come out the same whatever the number of threads.
+		template<class F>
+		void blocks( const cell_size_t size, const cell_size_t block, F fn )
+		{
+			spans( size, [&]( unsigned w, cell_size_t begin, cell_size_t end )
+			{
+				std::uint_fast64_t first = ( std::uint_fast64_t( begin ) + block - 1 ) / block;
+				
+				for ( std::uint_fast64_t b = first * block; b < end; b += block )
+					fn( w, cell_size_t( b ), cell_size_t( std::min<std::uint_fast64_t>( size,
+					                                      b + block ) ) );
+			} );
+		}
+	}
+}
+
+#endif
@@ -0,0 +1,21 @@
+# Earth-like hypsometry. This is the built-in default, with the plains
+# coverage of 2/3 rounded to 0.6667.
+#
+# depth, height and relief are in km at Earth's radius and are scaled with
+# the planet. relief is used both above and below sea level on dry worlds.
+#
+# Each "ocean" knot maps a fraction of the ocean (from the deepest cell up)
+# to a level between -1 (deepest trench) and 0 (sea level). Each "land" knot
+# maps a fraction of the land (from the shore up) to a level between 0 and 1
+# (highest peak). Knots must increase in both coverage and level, and
+# depth, height and relief must be positive.
+
+depth   18.0
+height  13.4
+relief  15.7
+
+ocean   0.15  -0.6  # trench -> floor
+ocean   0.70  -0.4  # floor -> drop
+ocean   0.85  -0.1  # drop -> shelf
+
+land    0.6667 0.125 # plains -> mountain
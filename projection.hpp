@@ -89,7 +89,7 @@ namespace zw
 			}
 			
 			void drawGraticule( plotter::gs &map, int spacing = 15,
-			                    unsigned char color = 1 )
+			                    unsigned char color = 1 ) const
 			{
 				real_t radians = DEG2RAD( spacing );
 				
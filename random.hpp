@@ -0,0 +1,54 @@
+#ifndef RANDOM_HPP
+#define RANDOM_HPP
+
+// ZaWarudo Headers
+#include "config.hpp"
+
+namespace zw
+{
+	//
+	// Counter-based random numbers. The number at an index is a hash of the
+	// seed and the index rather than the next state of a sequence, so a
+	// stage can draw the numbers of any iteration or cell on any thread, in
+	// any order, and always get the same ones. The hash is the SplitMix64
+	// finaliser over a Weyl sequence.
+	//
+	class counterRng
+	{
+	public:
+	
+		// Constructors
+		
+		explicit counterRng( const std::uint64_t seed = 0 )
+			: key( mix( seed ) )
+		{}
+		
+		// Functions
+		
+		// Random bits at an index.
+		std::uint64_t operator()( const std::uint64_t index ) const
+		{
+			return mix( key + ( index + 1 ) * UINT64_C( 0x9E3779B97F4A7C15 ) );
+		}
+		
+		// Uniform in [low, high) at an index, from the top 53 bits.
+		double uniform( const std::uint64_t index, const double low = 0,
+		                const double high = 1 ) const
+		{
+			return low + ( high - low ) * ( ( *this )( index ) >> 11 ) / 9007199254740992.0;
+		}
+		
+	private:
+	
+		static std::uint64_t mix( std::uint64_t z )
+		{
+			z = ( z ^ ( z >> 30 ) ) * UINT64_C( 0xBF58476D1CE4E5B9 );
+			z = ( z ^ ( z >> 27 ) ) * UINT64_C( 0x94D049BB133111EB );
+			return z ^ ( z >> 31 );
+		}
+		
+		std::uint64_t key;
+	};
+}
+
+#endif
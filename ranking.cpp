@@ -0,0 +1,100 @@
+// ZaWarudo Headers
+#include "ranking.hpp"
+#include "statistics.hpp"
+
+// Utility Headers
+#include "parallel.hpp"
+#include "serialize.hpp"
+
+// C++ STL
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+zw::ranking::ranking( const real_t *field, const cell_size_t size )
+	: order_( statistics::sort( field, size ) ), sorted_( size )
+{
+	parallel::spans( size, [&]( unsigned, cell_size_t begin, cell_size_t end )
+	{
+		for ( cell_size_t r = begin; r < end; ++r )
+			sorted_[r] = field[order_[r]];
+	} );
+}
+
+zw::real_t zw::ranking::seaLevel( const real_t percent ) const
+{
+	assert( percent >= 0 && percent < 1.0 );
+	
+	if ( percent == 0 || sorted_.front() == sorted_.back() )
+		return 0.5 * ( sorted_.front() + sorted_.back() );
+		
+	// Same placement as geoData::findElevation, between the cells on either
+	// side of the coverage.
+	
+	cell_size_t rank = std::max<cell_size_t>( 1, std::min<cell_size_t>( size() - 1,
+	                   cell_size_t( percent * size() + 0.5 ) ) );
+	real_t level = 0.5 * ( sorted_[rank - 1] + sorted_[rank] );
+	
+	return ( level > sorted_[rank - 1] ) ? level : sorted_[rank];
+}
+
+zw::cell_size_t zw::ranking::flooded( const real_t level ) const
+{
+	return std::lower_bound( sorted_.begin(), sorted_.end(),
+	                         level ) - sorted_.begin();
+}
+
+bool zw::ranking::load( const std::string &file, const real_t *field,
+                        const cell_size_t size )
+{
+	serialize::input handle( file );
+	
+	if ( !handle.exists() || handle.read<std::size_t>() != sizeof( real_t )
+	        || handle.read<cell_size_t>() != size )
+		return false;
+		
+	std::vector<cell_size_t> order( size );
+	handle.read( order.data(), size );
+	
+	if ( !handle.exists() )
+		return false;
+		
+	// Only the order is kept, since elevations pick up rounding on their way
+	// through a world file. Rounding can only swap near ties, which a single
+	// insertion pass puts back; anything bigger means the index is stale.
+	
+	std::vector<real_t> sorted( size );
+	
+	for ( cell_size_t r = 0; r < size; ++r )
+	{
+		if ( order[r] >= size )
+			return false;
+			
+		sorted[r] = field[order[r]];
+		
+		for ( cell_size_t i = r; i > 0 && sorted[i - 1] > sorted[i]; --i )
+		{
+			real_t slack = 4 * std::numeric_limits<real_t>::epsilon() * std::fabs( sorted[i] );
+			
+			if ( sorted[i - 1] - sorted[i] > slack )
+				return false;
+				
+			std::swap( sorted[i - 1], sorted[i] );
+			std::swap( order[i - 1], order[i] );
+		}
+	}
+	
+	order_.swap( order );
+	sorted_.swap( sorted );
+	return true;
+}
+
+void zw::ranking::save( const std::string &file ) const
+{
+	serialize::output handle( file );
+	
+	handle.write<std::size_t>( sizeof( real_t ) );
+	handle.write( size() );
+	handle.write( order_.data(), size() );
+}
+
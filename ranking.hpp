@@ -0,0 +1,49 @@
+#ifndef RANKING_HPP
+#define RANKING_HPP
+
+// ZaWarudo Headers
+#include "config.hpp"
+
+// C++ STL
+#include <string>
+
+namespace zw
+{
+	//
+	// Cells sorted by elevation. This is saved alongside a world so sea level
+	// questions can be answered without scanning the grid again.
+	//
+	class ranking
+	{
+	public:
+	
+		// Constructors
+		
+		ranking() = default;
+		ranking( const real_t *field, const cell_size_t size );
+		
+		// Functions
+		
+		cell_size_t size() const {return order_.size();}
+		cell_size_t cell( const cell_size_t rank ) const {return order_[rank];}
+		real_t value( const cell_size_t rank ) const {return sorted_[rank];}
+		range_t range() const {return range_t( sorted_.front(), sorted_.back() );}
+		
+		// Sea level that leaves the given fraction of cells below it.
+		real_t seaLevel( const real_t percent ) const;
+		
+		// Number of cells below the given sea level.
+		cell_size_t flooded( const real_t level ) const;
+		
+		bool load( const std::string &file, const real_t *field,
+		           const cell_size_t size );
+		void save( const std::string &file ) const;
+		
+	private:
+		std::vector<cell_size_t> order_;
+		std::vector<real_t> sorted_;
+	};
+}
+
+#endif
+
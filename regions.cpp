@@ -0,0 +1,145 @@
+// ZaWarudo Headers
+#include "regions.hpp"
+
+// Utility Headers
+#include "parallel.hpp"
+
+// C++ STL
+#include <fstream>
+
+//
+// Internal Stuff
+//
+
+namespace
+{
+	struct partial
+	{
+		zw::cell_size_t cells = 0;
+		double area = 0, weighted = 0, land = 0;
+		double x = 0, y = 0, z = 0;
+		zw::real_t min = std::numeric_limits<zw::real_t>::max();
+		zw::real_t max = std::numeric_limits<zw::real_t>::lowest();
+	};
+	
+	// A third of each triangle around the cell, which splits the surface
+	// between cells without gaps.
+	double cellArea( const zw::geoData::geo_ptr &data, const zw::cell_size_t c )
+	{
+		const zw::geoData &cell = data[c];
+		int spokes = ( cell.link[5] == zw::geoData::nolink ) ? 5 : 6;
+		double area = 0;
+		
+		for ( int s = 0; s < spokes; ++s )
+		{
+			zw::vector a = data[cell.link[s]].v - cell.v;
+			zw::vector b = data[cell.link[( s + 1 ) % spokes]].v - cell.v;
+			area += a.crossProduct( b ).magnitude();
+		}
+		
+		return area / 6.0;
+	}
+}
+
+//
+// Public API
+//
+
+zw::regions::regions( const geoData::geo_ptr &data,
+                      const geoData::field_ptr &elevation, const cell_size_t size,
+                      const real_t seaLevel, const real_t radius )
+{
+	std::vector<std::vector<partial>> partials( parallel::workers( size ) );
+	
+	parallel::spans( size, [&]( unsigned w, cell_size_t begin, cell_size_t end )
+	{
+		auto &totals = partials[w];
+		totals.resize( REGION_LIMIT );
+		
+		for ( cell_size_t c = begin; c < end; ++c )
+		{
+			partial &p = totals[data[c].region];
+			double area = cellArea( data, c );
+			real_t height = elevation[c];
+			
+			p.cells += 1;
+			p.area += area;
+			p.weighted += area * height;
+			p.land += ( height >= seaLevel ) ? area : 0;
+			p.x += area * data[c].v.x;
+			p.y += area * data[c].v.y;
+			p.z += area * data[c].v.z;
+			p.min = std::min( p.min, height );
+			p.max = std::max( p.max, height );
+		}
+	} );
+	
+	// Fold the workers together in order so the sums don't depend on timing.
+	
+	std::vector<partial> totals( REGION_LIMIT );
+	double surface = 0;
+	
+	for ( auto const &worker : partials )
+	{
+		for ( std::size_t r = 0; r < worker.size(); ++r )
+		{
+			partial &t = totals[r];
+			const partial &p = worker[r];
+			t.cells += p.cells;
+			t.area += p.area;
+			t.weighted += p.weighted;
+			t.land += p.land;
+			t.x += p.x;
+			t.y += p.y;
+			t.z += p.z;
+			t.min = std::min( t.min, p.min );
+			t.max = std::max( t.max, p.max );
+			surface += p.area;
+		}
+	}
+	
+	// The flat triangles fall a little short of the sphere, so scale the
+	// areas to add up to its whole surface.
+	
+	double scale = 4.0 * M_PI * radius * radius / surface;
+	regions_.resize( REGION_LIMIT );
+	
+	for ( std::size_t r = 0; r < REGION_LIMIT; ++r )
+	{
+		const partial &t = totals[r];
+		aggregate &a = regions_[r];
+		a.cells = t.cells;
+		a.area = t.area * scale;
+		a.mean = t.cells ? t.weighted / t.area : 0;
+		a.min = t.cells ? t.min : 0;
+		a.max = t.cells ? t.max : 0;
+		a.land = t.cells ? t.land / t.area : 0;
+		a.centroid = coord( vector( t.x, t.y, t.z ) );
+		a.centroid.alt = 1.0;
+	}
+}
+
+bool zw::regions::save( const std::string &file ) const
+{
+	std::ofstream handle( file );
+	
+	if ( !handle.good() )
+		return false;
+		
+	handle << "region,cells,area,mean,min,max,land,longitude,latitude\n";
+	
+	for ( std::size_t r = 0; r < regions_.size(); ++r )
+	{
+		const aggregate &a = regions_[r];
+		
+		if ( a.cells == 0 )
+			continue;
+			
+		handle << r << "," << a.cells << "," << a.area << "," << a.mean << "," << a.min
+		       << "," << a.max << "," << a.land << "," << RAD2DEG( a.centroid.lon ) << ","
+		       << RAD2DEG( a.centroid.lat ) << "\n";
+	}
+	
+	return handle.good();
+}
+
@@ -0,0 +1,53 @@
+#ifndef REGIONS_HPP
+#define REGIONS_HPP
+
+// ZaWarudo Headers
+#include "config.hpp"
+#include "geodesic.hpp"
+
+// Utility Headers
+#include "coord.hpp"
+
+// C++ STL
+#include <string>
+
+namespace zw
+{
+	//
+	// Per-region summary of a world, gathered in one parallel pass. Each
+	// worker keeps its own partial totals, which are merged at the end.
+	//
+	class regions
+	{
+	public:
+	
+		struct aggregate
+		{
+			cell_size_t cells;
+			double area;     // on a sphere of the given radius
+			double mean;     // weighted by area
+			real_t min, max;
+			double land;     // fraction of the area at or above sea level
+			coord centroid;  // of the area, on the surface
+		};
+		
+		// Constructors
+		
+		regions( const geoData::geo_ptr &data, const geoData::field_ptr &elevation,
+		         const cell_size_t size, const real_t seaLevel, const real_t radius );
+		         
+		// Functions
+		
+		std::size_t size() const {return regions_.size();}
+		const aggregate &operator[]( const region_t r ) const {return regions_[r];}
+		
+		// One row per region that has any cells.
+		bool save( const std::string &file ) const;
+		
+	private:
+		std::vector<aggregate> regions_;
+	};
+}
+
+#endif
+
@@ -33,6 +33,12 @@ namespace serialize
 			fileStream.read( reinterpret_cast<char *>( data ), sizeof( T ) * size );
 		}
 		
+		template<typename T>
+		void skip( std::size_t count )
+		{
+			fileStream.seekg( sizeof( T ) * count, std::ifstream::cur );
+		}
+		
 		bool exists() const
 		{
 			return fileStream.good();
@@ -60,9 +66,14 @@ namespace serialize
 		}
 		
 		template<typename T>
-		void write( T *data, unsigned int size )
+		void write( const T *data, unsigned int size )
 		{
-			fileStream.write( reinterpret_cast<char *>( data ), sizeof( T ) * size );
+			fileStream.write( reinterpret_cast<const char *>( data ), sizeof( T ) * size );
+		}
+		
+		bool exists() const
+		{
+			return fileStream.good();
 		}
 		
 		void close()
@@ -0,0 +1,159 @@
+// ZaWarudo Headers
+#include "sketch.hpp"
+
+// Utility Headers
+#include "parallel.hpp"
+
+const zw::cell_size_t zw::sketch::block;
+
+zw::sketch::sketch( const std::size_t accuracy )
+	: levels_( 1 ), capacity_( 1, accuracy ), coin_( 0 ), accuracy_( accuracy ),
+	  count_( 0 ), variance_( 0 ),
+	  min_( std::numeric_limits<real_t>::max() ),
+	  max_( std::numeric_limits<real_t>::lowest() )
+{
+	assert( accuracy >= 2 );
+}
+
+zw::sketch zw::sketch::of( const real_t *field, const cell_size_t size,
+                           const std::size_t accuracy )
+{
+	std::vector<sketch> parts( ( std::uint_fast64_t( size ) + block - 1 ) / block,
+	                           sketch( accuracy ) );
+	                           
+	parallel::blocks( size, block, [&]( unsigned, cell_size_t begin, cell_size_t end )
+	{
+		for ( cell_size_t c = begin; c < end; ++c )
+			parts[begin / block].insert( field[c] );
+	} );
+	
+	sketch result( accuracy );
+	
+	for ( auto const &part : parts )
+		result.merge( part );
+		
+	return result;
+}
+
+void zw::sketch::merge( const sketch &other )
+{
+	assert( accuracy_ == other.accuracy_ );
+	
+	if ( levels_.size() < other.levels_.size() )
+	{
+		levels_.resize( other.levels_.size() );
+		plan();
+	}
+	
+	for ( std::size_t h = 0; h < other.levels_.size(); ++h )
+		levels_[h].insert( levels_[h].end(), other.levels_[h].begin(),
+		                   other.levels_[h].end() );
+		                   
+	min_ = std::min( min_, other.min_ );
+	max_ = std::max( max_, other.max_ );
+	count_ += other.count_;
+	variance_ += other.variance_;
+	coin_ ^= other.coin_;
+	compress();
+}
+
+std::vector<zw::real_t> zw::sketch::quantiles( const std::vector<real_t>
+        &percents ) const
+{
+	// Every retained value stands in for 2^level of the values seen.
+	
+	std::vector<std::pair<real_t, cell_size_t>> items;
+	
+	for ( std::size_t h = 0; h < levels_.size(); ++h )
+		for ( auto const value : levels_[h] )
+			items.push_back( std::make_pair( value, cell_size_t( 1 ) << h ) );
+			
+	std::sort( items.begin(), items.end() );
+	std::vector<cell_size_t> through( items.size() );
+	cell_size_t total = 0;
+	
+	for ( std::size_t i = 0; i < items.size(); ++i )
+		through[i] = total += items[i].second;
+		
+	assert( total == count_ );
+	
+	auto atRank = [&]( const cell_size_t rank )
+	{
+		return items[std::upper_bound( through.begin(), through.end(),
+		                               rank ) - through.begin()].first;
+	};
+	
+	std::vector<real_t> result;
+	result.reserve( percents.size() );
+	
+	for ( auto const percent : percents )
+	{
+		assert( percent >= 0 && percent < 1.0 );
+		
+		if ( percent == 0 || min_ == max_ )
+		{
+			result.push_back( 0.5 * ( min_ + max_ ) );
+			continue;
+		}
+		
+		cell_size_t rank = std::max<cell_size_t>( 1, std::min<cell_size_t>( count_ - 1,
+		                   cell_size_t( percent * count_ + 0.5 ) ) );
+		real_t below = atRank( rank - 1 ), above = atRank( rank );
+		real_t level = 0.5 * ( below + above );
+		result.push_back( ( level > below ) ? level : above );
+	}
+	
+	return result;
+}
+
+void zw::sketch::compress()
+{
+	assert( capacity_.size() == levels_.size() );
+	
+	for ( std::size_t h = 0; h < levels_.size(); ++h )
+	{
+		if ( levels_[h].size() < capacity_[h] )
+			continue;
+			
+		if ( h + 1 == levels_.size() )
+		{
+			levels_.emplace_back();
+			plan();
+		}
+		
+		// Keep the odd or even values at random and carry an odd one out
+		// over. Each compaction moves a rank up or down by one item's weight
+		// with even odds, so errors mostly cancel.
+		
+		auto &level = levels_[h];
+		std::sort( level.begin(), level.end() );
+		std::size_t pairs = level.size() / 2;
+		std::size_t offset = toss() ? 1 : 0;
+		
+		for ( std::size_t i = 0; i < pairs; ++i )
+			levels_[h + 1].push_back( level[2 * i + offset] );
+			
+		level.erase( level.begin(), level.begin() + 2 * pairs );
+		variance_ += std::ldexp( 1.0, 2 * int( h ) );
+	}
+}
+
+bool zw::sketch::toss()
+{
+	// SplitMix64, so the same values always give the same sketch.
+	std::uint64_t z = ( coin_ += 0x9E3779B97F4A7C15ull );
+	z = ( z ^ ( z >> 30 ) ) * 0xBF58476D1CE4E5B9ull;
+	z = ( z ^ ( z >> 27 ) ) * 0x94D049BB133111EBull;
+	return ( z ^ ( z >> 31 ) ) >> 63;
+}
+
+// Lower levels get geometrically less room than the top one, so the room
+// of every level changes whenever one is added.
+void zw::sketch::plan()
+{
+	capacity_.resize( levels_.size() );
+	
+	for ( std::size_t l = 0; l < levels_.size(); ++l )
+		capacity_[l] = std::max<std::size_t>( 2, std::size_t( std::ceil( accuracy_ *
+		                                      std::pow( 2.0 / 3.0, levels_.size() - 1 - l ) ) ) );
+}
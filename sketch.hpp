@@ -0,0 +1,74 @@
+#ifndef SKETCH_HPP
+#define SKETCH_HPP
+
+// ZaWarudo Headers
+#include "config.hpp"
+
+// C++ STL
+#include <algorithm>
+
+namespace zw
+{
+	//
+	// Mergeable quantile sketch (KLL) over a per-cell field. Values can be
+	// fed in any order and sketches of separate chunks merged, so quantiles
+	// never need a second pass over the grid. Memory grows with the log of
+	// the number of values.
+	//
+	class sketch
+	{
+	public:
+	
+		// Constructors
+		
+		explicit sketch( const std::size_t accuracy = 1024 );
+		
+		// Sketch of a whole field, built one sketch per block and merged in
+		// order so the result doesn't depend on the number of threads.
+		static sketch of( const real_t *field, const cell_size_t size,
+		                  const std::size_t accuracy = 1024 );
+		static const cell_size_t block = 65536;
+		
+		// Functions
+		
+		void insert( const real_t value )
+		{
+			min_ = std::min( min_, value );
+			max_ = std::max( max_, value );
+			++count_;
+			levels_[0].push_back( value );
+			
+			if ( levels_[0].size() >= capacity_[0] )
+				compress();
+		}
+		
+		void merge( const sketch &other );
+		
+		cell_size_t count() const {return count_;}
+		range_t range() const {return range_t( min_, max_ );}
+		
+		// Rank error of a quantile, as a fraction of the count, that holds
+		// with three standard deviations of confidence.
+		double error() const {return count_ > 0 ? 3 * std::sqrt( variance_ ) / count_ : 0;}
+		
+		// Same placement as geoData::findElevations, between the values on
+		// either side of each coverage.
+		std::vector<real_t> quantiles( const std::vector<real_t> &percents ) const;
+		
+	private:
+		void compress();
+		void plan();
+		bool toss();
+		
+		std::vector<std::vector<real_t>> levels_;
+		std::vector<std::size_t> capacity_;
+		std::uint64_t coin_;
+		std::size_t accuracy_;
+		cell_size_t count_;
+		double variance_;
+		real_t min_, max_;
+	};
+}
+
+#endif
+
@@ -0,0 +1,297 @@
+// ZaWarudo Headers
+#include "statistics.hpp"
+#include "parallel.hpp"
+
+#if defined( __AVX2__ )
+#	include <immintrin.h>
+#endif
+
+//
+// Internal Stuff
+//
+
+namespace
+{
+	using zw::cell_size_t;
+	using zw::real_t;
+	
+	struct extent
+	{
+		real_t minima, maxima;
+	};
+	
+	extent scalarExtremes( const real_t *field, cell_size_t begin,
+	                       const cell_size_t end )
+	{
+		extent e = {std::numeric_limits<real_t>::max(), 0};
+		
+		for ( ; begin < end; ++begin )
+		{
+			e.minima = std::min( e.minima, field[begin] );
+			e.maxima = std::max( e.maxima, field[begin] );
+		}
+		
+		return e;
+	}
+	
+#if defined( __AVX2__ )
+
+	//
+	// AVX2 Kernels
+	// Each handles the bulk of a span eight floats (or four doubles) at a
+	// time and leaves the tail to the scalar version.
+	//
+	
+	inline float horizontalMin( __m256 v )
+	{
+		__m128 m = _mm_min_ps( _mm256_castps256_ps128( v ), _mm256_extractf128_ps( v, 1 ) );
+		m = _mm_min_ps( m, _mm_movehl_ps( m, m ) );
+		m = _mm_min_ss( m, _mm_shuffle_ps( m, m, 1 ) );
+		return _mm_cvtss_f32( m );
+	}
+	
+	inline float horizontalMax( __m256 v )
+	{
+		__m128 m = _mm_max_ps( _mm256_castps256_ps128( v ), _mm256_extractf128_ps( v, 1 ) );
+		m = _mm_max_ps( m, _mm_movehl_ps( m, m ) );
+		m = _mm_max_ss( m, _mm_shuffle_ps( m, m, 1 ) );
+		return _mm_cvtss_f32( m );
+	}
+	
+	inline double horizontalMin( __m256d v )
+	{
+		__m128d m = _mm_min_pd( _mm256_castpd256_pd128( v ), _mm256_extractf128_pd( v, 1 ) );
+		return _mm_cvtsd_f64( _mm_min_sd( m, _mm_unpackhi_pd( m, m ) ) );
+	}
+	
+	inline double horizontalMax( __m256d v )
+	{
+		__m128d m = _mm_max_pd( _mm256_castpd256_pd128( v ), _mm256_extractf128_pd( v, 1 ) );
+		return _mm_cvtsd_f64( _mm_max_sd( m, _mm_unpackhi_pd( m, m ) ) );
+	}
+	
+#	if SPACE_SAVING == 2
+	
+	inline extent vectorExtremes( const float *field, const cell_size_t begin,
+	                              const cell_size_t end )
+	{
+		cell_size_t c = begin;
+		extent e = {std::numeric_limits<float>::max(), 0};
+		__m256 minima = _mm256_set1_ps( e.minima );
+		__m256 maxima = _mm256_set1_ps( e.maxima );
+		
+		for ( ; c + 8 <= end; c += 8 )
+		{
+			__m256 v = _mm256_loadu_ps( field + c );
+			minima = _mm256_min_ps( minima, v );
+			maxima = _mm256_max_ps( maxima, v );
+		}
+		
+		e = scalarExtremes( field, c, end );
+		e.minima = std::min( e.minima, horizontalMin( minima ) );
+		e.maxima = std::max( e.maxima, horizontalMax( maxima ) );
+		return e;
+	}
+	
+#	else
+	
+	inline extent vectorExtremes( const double *field, const cell_size_t begin,
+	                              const cell_size_t end )
+	{
+		cell_size_t c = begin;
+		extent e = {std::numeric_limits<double>::max(), 0};
+		__m256d minima = _mm256_set1_pd( e.minima );
+		__m256d maxima = _mm256_set1_pd( e.maxima );
+		
+		for ( ; c + 4 <= end; c += 4 )
+		{
+			__m256d v = _mm256_loadu_pd( field + c );
+			minima = _mm256_min_pd( minima, v );
+			maxima = _mm256_max_pd( maxima, v );
+		}
+		
+		e = scalarExtremes( field, c, end );
+		e.minima = std::min( e.minima, horizontalMin( minima ) );
+		e.maxima = std::max( e.maxima, horizontalMax( maxima ) );
+		return e;
+	}
+	
+#	endif
+	
+#	define KERNEL( name ) vector##name
+#else
+#	define KERNEL( name ) scalar##name
+#endif
+}
+
+//
+// Public API
+//
+
+zw::range_t zw::statistics::extremes( const real_t *field,
+                                      const cell_size_t size )
+{
+	std::vector<extent> partial( parallel::workers( size ) );
+	
+	parallel::spans( size, [&]( unsigned w, cell_size_t begin, cell_size_t end )
+	{
+		partial[w] = KERNEL( Extremes )( field, begin, end );
+	} );
+	
+	extent e = partial[0];
+	
+	for ( auto const &p : partial )
+	{
+		e.minima = std::min( e.minima, p.minima );
+		e.maxima = std::max( e.maxima, p.maxima );
+	}
+	
+	return std::make_pair( e.minima, e.maxima );
+}
+
+std::vector<zw::real_t> zw::statistics::select( const real_t *field,
+        const cell_size_t size, const std::vector<cell_size_t> &ranks )
+{
+	const int digitBits = 16;
+	const std::size_t digits = std::size_t( 1 ) << digitBits;
+	
+	std::vector<key_t> prefix( ranks.size(), 0 );
+	std::vector<cell_size_t> remain( ranks );
+	
+	for ( int shift = keyBits - digitBits; shift >= 0; shift -= digitBits )
+	{
+		// Ranks sharing the bits found so far share a histogram.
+		
+		std::vector<key_t> groups;
+		std::vector<std::size_t> group( ranks.size() );
+		
+		for ( std::size_t r = 0; r < ranks.size(); ++r )
+		{
+			assert( ranks[r] < size );
+			auto found = std::find( groups.begin(), groups.end(), prefix[r] );
+			group[r] = found - groups.begin();
+			
+			if ( found == groups.end() )
+				groups.push_back( prefix[r] );
+		}
+		
+		const bool first = ( shift == keyBits - digitBits );
+		std::vector<std::vector<cell_size_t>> partial( parallel::workers( size ) );
+		
+		parallel::spans( size, [&]( unsigned w, cell_size_t begin, cell_size_t end )
+		{
+			auto &counts = partial[w];
+			counts.assign( groups.size() * digits, 0 );
+			
+			for ( cell_size_t c = begin; c < end; ++c )
+			{
+				key_t key = toKey( field[c] );
+				std::size_t digit = ( key >> shift ) & ( digits - 1 );
+				
+				if ( first )
+				{
+					++counts[digit];
+					continue;
+				}
+				
+				key_t high = key >> ( shift + digitBits );
+				
+				for ( std::size_t g = 0; g < groups.size(); ++g )
+				{
+					if ( groups[g] == high )
+					{
+						++counts[g * digits + digit];
+						break;
+					}
+				}
+			}
+		} );
+		
+		for ( std::size_t w = 1; w < partial.size(); ++w )
+			for ( std::size_t i = 0; i < partial[0].size(); ++i )
+				partial[0][i] += partial[w][i];
+				
+		for ( std::size_t r = 0; r < ranks.size(); ++r )
+		{
+			const cell_size_t *counts = &partial[0][group[r] * digits];
+			std::size_t digit = 0;
+			
+			while ( remain[r] >= counts[digit] )
+				remain[r] -= counts[digit++];
+				
+			assert( digit < digits );
+			prefix[r] = ( prefix[r] << digitBits ) | key_t( digit );
+		}
+	}
+	
+	std::vector<real_t> result;
+	
+	for ( auto key : prefix )
+		result.push_back( fromKey( key ) );
+		
+	return result;
+}
+
+std::vector<zw::cell_size_t> zw::statistics::sort( const real_t *field,
+        const cell_size_t size )
+{
+	const int digitBits = 16;
+	const std::size_t digits = std::size_t( 1 ) << digitBits;
+	const unsigned count = parallel::workers( size );
+	
+	std::vector<key_t> keys( size ), keysOut( size );
+	std::vector<cell_size_t> order( size ), orderOut( size );
+	std::vector<std::vector<cell_size_t>> offsets( count );
+	
+	parallel::spans( size, [&]( unsigned, cell_size_t begin, cell_size_t end )
+	{
+		for ( cell_size_t c = begin; c < end; ++c )
+		{
+			keys[c] = toKey( field[c] );
+			order[c] = c;
+		}
+	} );
+	
+	for ( int shift = 0; shift < keyBits; shift += digitBits )
+	{
+		parallel::spans( size, [&]( unsigned w, cell_size_t begin, cell_size_t end )
+		{
+			offsets[w].assign( digits, 0 );
+			
+			for ( cell_size_t c = begin; c < end; ++c )
+				++offsets[w][( keys[c] >> shift ) & ( digits - 1 )];
+		} );
+		
+		// Each worker scatters its span after the same digit from every
+		// earlier span, which keeps the sort stable.
+		
+		cell_size_t total = 0;
+		
+		for ( std::size_t d = 0; d < digits; ++d )
+		{
+			for ( unsigned w = 0; w < count; ++w )
+			{
+				cell_size_t here = offsets[w][d];
+				offsets[w][d] = total;
+				total += here;
+			}
+		}
+		
+		parallel::spans( size, [&]( unsigned w, cell_size_t begin, cell_size_t end )
+		{
+			auto &next = offsets[w];
+			
+			for ( cell_size_t c = begin; c < end; ++c )
+			{
+				cell_size_t to = next[( keys[c] >> shift ) & ( digits - 1 )]++;
+				keysOut[to] = keys[c];
+				orderOut[to] = order[c];
+			}
+		} );
+		
+		keys.swap( keysOut );
+		order.swap( orderOut );
+	}
+	
+	return order;
+}
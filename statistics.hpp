@@ -0,0 +1,64 @@
+#ifndef STATISTICS_HPP
+#define STATISTICS_HPP
+
+// ZaWarudo Headers
+#include "config.hpp"
+
+// C Standard Library
+#include <cstring>
+
+// C++ STL
+#include <algorithm>
+#include <type_traits>
+
+namespace zw
+{
+	namespace statistics
+	{
+		//
+		// Parallel reductions over a per-cell field. Each pass splits the grid
+		// across worker threads and uses AVX2 kernels when built with them.
+		//
+		range_t extremes( const real_t *field, const cell_size_t size );
+		
+		//
+		// Order-preserving mapping between real_t and unsigned keys so values
+		// can be selected digit by digit.
+		//
+		using key_t = std::conditional<sizeof( real_t ) == 4, std::uint32_t,
+		      std::uint64_t>::type;
+		const int keyBits = sizeof( key_t ) * 8;
+		const key_t keySign = key_t( 1 ) << ( keyBits - 1 );
+		
+		inline key_t toKey( const real_t value )
+		{
+			key_t bits;
+			std::memcpy( &bits, &value, sizeof( bits ) );
+			return ( bits & keySign ) ? ~bits : ( bits | keySign );
+		}
+		
+		inline real_t fromKey( key_t key )
+		{
+			real_t value;
+			key = ( key & keySign ) ? ( key & ~keySign ) : ~key;
+			std::memcpy( &value, &key, sizeof( value ) );
+			return value;
+		}
+		
+		//
+		// Exact order statistics by parallel radix select. Every requested
+		// rank is resolved together, 16 key bits per pass, so this takes two
+		// passes for float and four for double whatever the distribution.
+		//
+		std::vector<real_t> select( const real_t *field, const cell_size_t size,
+		                            const std::vector<cell_size_t> &ranks );
+		                            
+		//
+		// Cells in ascending order of the field, by parallel LSD radix sort.
+		// Ties keep their cell order.
+		//
+		std::vector<cell_size_t> sort( const real_t *field, const cell_size_t size );
+	}
+}
+
+#endif
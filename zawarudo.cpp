@@ -1,11 +1,28 @@
 // ZaWarudo Headers
 #include "geodesic.hpp"
 #include "projection.hpp"
+#include "ranking.hpp"
+#include "components.hpp"
+#include "regions.hpp"
+#include "cache.hpp"
+#include "multigrid.hpp"
+
+// Utility Headers
+#include "parallel.hpp"
 
 // Third-Party Headers
 #include "lib/ezOptionParser.hpp"
 #include "lib/noise.h"
 
+// C++ STL
+#include <cctype>
+#include <chrono>
+#include <cmath>
+#include <iomanip>
+#include <limits>
+#include <mutex>
+#include <unordered_set>
+
 static void show_usage( ez::ezOptionParser &opt )
 {
 	std::string usage;
@@ -41,6 +58,483 @@ static std::string getMapFile( const std::string &world,
 	return mapFile.str();
 }
 
+// Octaves a grid subdivided the given number of times can resolve. Octave i
+// repeats lacunarity^i times a unit and cells sit about sqrt(4 pi / cells)
+// apart on the unit sphere, so past two cells a repeat the finer octaves
+// only alias.
+static int resolvedOctaves( const double lacunarity, const int iterations )
+{
+	const double spacing = std::sqrt( 4 * M_PI / zw::cellsPerIteration( iterations ) );
+	return std::max( 1, int( std::log( 0.5 / spacing ) / std::log( lacunarity ) ) + 1 );
+}
+
+// Shapes the fBm, trench and ridge sums at a cell into the factor its
+// elevation is scaled by.
+template<class T>
+static T terrainFactor( T fractal, const T trench, const T ridges, const bool useRidged )
+{
+	if ( useRidged )
+	{
+		if ( fractal > 0.75 ) fractal = ( fractal - 0.75 ) * 0.5 + 0.75;
+		
+		if ( fractal < -0.75 ) fractal = ( fractal + 0.75 ) * 0.5 - 0.75;
+	}
+	
+	if ( ridges > 0.25 ) fractal += ( ridges - 0.25 ) * 4.0 / 3.0;
+	
+	if ( trench > 0.25 ) fractal -= ( trench - 0.25 ) * 4.0 / 3.0;
+	
+	return fractal * 0.2 + 1.0;
+}
+
+// How fast terrainFactor changes along the surface of the unit sphere at v,
+// given the sums it shaped there. The gradients come from each octave's
+// lattice corners and go through the same shaping, and only the part
+// across the sphere, away from v, is slope.
+template<class Basis>
+static double terrainSlope( const noise::Octave<Basis> &perlin, const noise::Octave<Basis> &fractl,
+                            const zw::vector &v, const double persistence, const bool usePerlin, const bool useRidged,
+                            const typename Basis::value_type fractal, const typename Basis::value_type trench,
+                            const typename Basis::value_type ridges )
+{
+	typedef typename Basis::value_type T;
+	
+	T fractals[3] = { 0, 0, 0 }, trenches[3] = { 0, 0, 0 }, crests[3] = { 0, 0, 0 };
+	T value, ridged;
+	
+	perlin.fused( v.x, v.y, v.z, persistence, value, usePerlin ? fractals : nullptr, ridged,
+	              useRidged ? trenches : nullptr );
+	              
+	if ( useRidged )
+		fractl.ridge( v.x, v.y, v.z, crests );
+		
+	T scale = useRidged && std::abs( fractal ) > 0.75 ? 0.5 : 1.0;
+	T gradient[3];
+	
+	for ( int d = 0; d < 3; ++d )
+	{
+		gradient[d] = fractals[d] * scale;
+		
+		if ( ridges > 0.25 ) gradient[d] += crests[d] * 4.0 / 3.0;
+		
+		if ( trench > 0.25 ) gradient[d] -= trenches[d] * 4.0 / 3.0;
+		
+		gradient[d] *= 0.2;
+	}
+	
+	const T radial = gradient[0] * v.x + gradient[1] * v.y + gradient[2] * v.z;
+	const T across[3] = { gradient[0] - radial * T( v.x ), gradient[1] - radial * T( v.y ),
+	                      gradient[2] - radial * T( v.z )
+	                    };
+	return std::sqrt( across[0] * across[0] + across[1] * across[1] + across[2] * across[2] );
+}
+
+// Fills a layer with the terrain noise of every cell, the factor its
+// elevation is scaled by. The noise is evaluated in the precision of the
+// basis, with no more than resolved octaves in either stack. Given a
+// tolerance, fBm on its own comes from the multigrid evaluator, and the
+// levels it used are returned. Given a slope, it gets how fast the layer
+// changes along the surface of the unit sphere at every cell, while the
+// layer itself stays as it would be without.
+template<class Basis>
+static std::vector<int> makeTerrain( const int octaves, const int resolved, const double lacunarity,
+                                     const unsigned long seed, const noise::Blend blend, const bool usePerlin,
+                                     const bool useRidged, const double persistence, const double tolerance,
+                                     const zw::geoData::geo_ptr &geodesic, const int iterations,
+                                     std::vector<double> &layer, std::vector<double> *slope )
+{
+	typedef typename Basis::value_type T;
+	
+	const noise::Octave<Basis> perlin( std::min( octaves, resolved ), lacunarity, seed, blend );
+	const noise::Octave<Basis> fractl( std::min( 6, resolved ), lacunarity, seed * 1.5, blend );
+	const zw::cell_size_t cells = zw::cellsPerIteration( iterations );
+	
+	std::vector<T> smooth;
+	std::vector<int> levels;
+	
+	if ( tolerance > 0 && usePerlin && !useRidged )
+		levels = zw::multigrid::fbm( perlin, persistence, tolerance, geodesic, iterations, smooth );
+		
+	// Blocks of cells run in parallel, each in batches with the
+	// coordinates laid out separately for the vector kernels. Every cell
+	// is independent, so the result is the same for any thread count.
+	
+	const zw::cell_size_t batch = 4096;
+	
+	zw::parallel::blocks( cells, zw::sketch::block, [&]( unsigned, zw::cell_size_t first,
+	                      zw::cell_size_t last )
+	{
+		std::vector<T> x( batch ), y( batch ), z( batch );
+		std::vector<T> fractal( batch, 0 ), trench( batch, 0 ), ridges( batch, 0 );
+		
+		for ( zw::cell_size_t begin = first; begin < last; begin += batch )
+		{
+			zw::cell_size_t count = std::min( batch, last - begin );
+			
+			for ( zw::cell_size_t i = 0; i < count; ++i )
+			{
+				x[i] = geodesic[begin + i].v.x;
+				y[i] = geodesic[begin + i].v.y;
+				z[i] = geodesic[begin + i].v.z;
+			}
+			
+			// fBm and trenches come from the same stack, so one pass over the
+			// lattice gives both, with the ridge stack alongside.
+			if ( smooth.empty() )
+				perlin.fused( x.data(), y.data(), z.data(), usePerlin ? fractal.data() : nullptr,
+				              useRidged ? trench.data() : nullptr, count, persistence,
+				              useRidged ? &fractl : nullptr, ridges.data() );
+			else
+				std::copy( smooth.begin() + begin, smooth.begin() + begin + count, fractal.begin() );
+				
+			for ( zw::cell_size_t i = 0; i < count; ++i )
+				layer[begin + i] = terrainFactor( fractal[i], trench[i], ridges[i], useRidged );
+				
+			// The slope is taken from the sums the layer was shaped from, so
+			// it follows the same branches whatever the kernels rounded.
+			
+			if ( slope )
+				for ( zw::cell_size_t i = 0; i < count; ++i )
+					( *slope )[begin + i] = terrainSlope( perlin, fractl, geodesic[begin + i].v, persistence,
+					                                      usePerlin, useRidged, fractal[i], trench[i], ridges[i] );
+		}
+	} );
+	
+	return levels;
+}
+
+// Sums the terrain noise of every cell three ways: with the fused batch
+// kernel, with each batch sum on its own and a point at a time. The fused
+// sums have to match the separate ones exactly, while the vector kernels
+// may stray from the point sums in the last few bits, reported in units of
+// the precision's epsilon.
+template<class Basis>
+static void checkKernels( const int octaves, const int resolved, const double lacunarity,
+                          const unsigned long seed, const noise::Blend blend, const double persistence,
+                          const zw::geoData::geo_ptr &geodesic, const int iterations, std::ostream &log )
+{
+	typedef typename Basis::value_type T;
+	
+	const noise::Octave<Basis> perlin( std::min( octaves, resolved ), lacunarity, seed, blend );
+	const noise::Octave<Basis> fractl( std::min( 6, resolved ), lacunarity, seed * 1.5, blend );
+	const zw::cell_size_t cells = zw::cellsPerIteration( iterations );
+	
+	std::vector<T> x( cells ), y( cells ), z( cells );
+	
+	for ( zw::cell_size_t c = 0; c < cells; ++c )
+	{
+		x[c] = geodesic[c].v.x;
+		y[c] = geodesic[c].v.y;
+		z[c] = geodesic[c].v.z;
+	}
+	
+	std::vector<T> fused[3], apart[3], point[3];
+	
+	for ( int s = 0; s < 3; ++s )
+	{
+		fused[s].resize( cells );
+		apart[s].resize( cells );
+		point[s].resize( cells );
+	}
+	
+	perlin.fused( x.data(), y.data(), z.data(), fused[0].data(), fused[1].data(), cells, persistence,
+	              &fractl, fused[2].data() );
+	perlin.noise( x.data(), y.data(), z.data(), apart[0].data(), cells, persistence );
+	perlin.ridge( x.data(), y.data(), z.data(), apart[1].data(), cells );
+	fractl.ridge( x.data(), y.data(), z.data(), apart[2].data(), cells );
+	
+	zw::parallel::spans( cells, [&]( unsigned, zw::cell_size_t first, zw::cell_size_t last )
+	{
+		for ( zw::cell_size_t c = first; c < last; ++c )
+		{
+			point[0][c] = perlin.noise( x[c], y[c], z[c], persistence );
+			point[1][c] = perlin.ridge( x[c], y[c], z[c] );
+			point[2][c] = fractl.ridge( x[c], y[c], z[c] );
+		}
+	} );
+	
+	bool same = true;
+	T worst = 0;
+	
+	for ( int s = 0; s < 3; ++s )
+	{
+		same = same && fused[s] == apart[s];
+		
+		for ( zw::cell_size_t c = 0; c < cells; ++c )
+			worst = std::max( worst, std::abs( fused[s][c] - point[s][c] ) );
+	}
+	
+	log << "  fused sums " << ( same ? "match" : "differ from" ) << " the separate sums" << std::endl;
+	log << "  batch sums within " << worst / std::numeric_limits<T>::epsilon() <<
+	    " epsilon of the point sums" << std::endl;
+}
+
+// Multiplies a terrain layer into the elevation and base heightmaps. With
+// sketching it also returns a sketch of the new elevations, and otherwise
+// an empty one.
+static zw::sketch applyTerrain( const std::vector<double> &layer,
+                                zw::geoData::field_ptr &elevation, zw::geoData::field_ptr &base,
+                                const zw::cell_size_t cells, const bool sketching )
+{
+	if ( !sketching )
+	{
+		zw::parallel::spans( cells, [&]( unsigned, zw::cell_size_t first, zw::cell_size_t last )
+		{
+			for ( zw::cell_size_t c = first; c < last; ++c )
+			{
+				elevation[c] *= layer[c];
+				base[c] *= layer[c];
+			}
+		} );
+		
+		return zw::sketch();
+	}
+	
+	std::vector<zw::sketch> parts( ( std::uint_fast64_t( cells ) +
+	                               zw::sketch::block - 1 ) / zw::sketch::block );
+	                               
+	zw::parallel::blocks( cells, zw::sketch::block, [&]( unsigned, zw::cell_size_t first,
+	                      zw::cell_size_t last )
+	{
+		zw::sketch &part = parts[first / zw::sketch::block];
+		
+		for ( zw::cell_size_t c = first; c < last; ++c )
+		{
+			elevation[c] *= layer[c];
+			base[c] *= layer[c];
+			part.insert( elevation[c] );
+		}
+	} );
+	
+	zw::sketch heights;
+	
+	for ( auto const &part : parts )
+		heights.merge( part );
+		
+	return heights;
+}
+
+// Surveys a world and, given a coverage or radius, rescales it. Everything
+// comes from one survey of the grid and, if the world changes, a single
+// rescaling pass. With useSketch the survey is read off the sketch filled
+// while generating noise instead. Returns the extremes.
+static zw::range_t elevations( zw::geoData::field_ptr &elevation,
+                               const zw::geoData::field_ptr &base, zw::sketch heights, const zw::cell_size_t cells,
+                               const bool layered, const zw::real_t hydro, const zw::real_t radius,
+                               const zw::profile &shape, const bool useSketch, zw::real_t &seaLevel, std::ostream &log )
+{
+	using namespace zw;
+	
+	geoData::survey_t survey;
+	
+	// Rescaling always starts over from the base heightmap, so coverage and
+	// radius can be changed as often as needed without distorting the land.
+	
+	if ( hydro > 0 || radius > 0 )
+	{
+		std::copy( base.get(), base.get() + cells, elevation.get() );
+		
+		if ( layered )
+			heights = sketch();
+	}
+	
+	if ( useSketch )
+	{
+		if ( heights.count() != cells )
+			heights = sketch::of( elevation.get(), cells );
+			
+		survey = geoData::survey( heights, hydro, shape );
+		log << "  sketch rank error: under " << heights.error() * 100 << "%" << std::endl;
+	}
+	else
+		survey = geoData::survey( elevation, cells, hydro, shape );
+		
+	real_t scale = ( radius > 0 ) ? radius / survey.seaLevel : 1;
+	range_t extremes = survey.range;
+	seaLevel = survey.seaLevel * scale;
+	
+	if ( hydro > 0 || radius > 0 )
+		extremes = geoData::rescale( elevation, cells, hydro, survey, shape, scale );
+		
+	log << "  high point: " << extremes.second << " km" << std::endl;
+	
+	if ( hydro > 0 && seaLevel > extremes.first )
+		log << "  sea level:  " << seaLevel << " km" << std::endl;
+		
+	log << "  low point:  " << extremes.first << " km" << std::endl;
+	return extremes;
+}
+
+// Projection for a map type, turning aliases into the projection they
+// stand for and clearing the standard parallel where it doesn't apply.
+static std::unique_ptr<zw::projection::base> makeView( std::string &mapType,
+        zw::real_t &parallel )
+{
+	using namespace zw;
+	using proj_ptr = std::unique_ptr<projection::base>;
+	
+	// Named cylindrical equal-area projections and their parallels.
+	if ( mapType == "behrmann" )
+	{
+		mapType = "cea";
+		parallel = 30.0;
+	}
+	else if ( mapType == "gall-peters" )
+	{
+		mapType = "cea";
+		parallel = 45.0;
+	}
+	else if ( mapType == "hobo-dyer" )
+	{
+		mapType = "cea";
+		parallel = 37.5;
+	}
+	else if ( mapType == "lambert" )
+	{
+		mapType = "cea";
+		parallel = 0;
+	}
+	
+	if ( mapType == "plate-carree" )
+	{
+		mapType = "equirect";
+		parallel = 0;
+	}
+	
+	proj_ptr view;
+	
+	if ( mapType == "aitoff" )
+	{
+		view = proj_ptr( new projection::aitoff() );
+		parallel = 0;
+	}
+	else if ( mapType == "braun" )
+	{
+		view = proj_ptr( new projection::stereographic( 1 ) );
+		parallel = 0;
+	}
+	else if ( mapType == "cea" )
+		view = proj_ptr( new projection::equalarea( DEG2RAD( parallel ) ) );
+	else if ( mapType == "gall" )
+	{
+		view = proj_ptr( new projection::stereographic( 2 ) );
+		parallel = 0;
+	}
+	else if ( mapType == "hammer" )
+	{
+		view = proj_ptr( new projection::hammer() );
+		parallel = 0;
+	}
+	else if ( mapType == "kavrayskiy" )
+	{
+		view = proj_ptr( new projection::kavrayskiy() );
+		parallel = 0;
+	}
+	else if ( mapType == "mercator" )
+	{
+		view = proj_ptr( new projection::mercator() );
+		parallel = 0;
+	}
+	else if ( mapType == "miller" )
+	{
+		view = proj_ptr( new projection::miller() );
+		parallel = 0;
+	}
+	else if ( mapType == "ortelius" )
+	{
+		view = proj_ptr( new projection::ortelius() );
+		parallel = 0;
+	}
+	else if ( mapType == "orthographic" )
+		view = proj_ptr( new projection::orthographic( DEG2RAD( parallel ) ) );
+	else if ( mapType == "sinusoidal" )
+	{
+		view = proj_ptr( new projection::sinusoidal() );
+		parallel = 0;
+	}
+	else if ( mapType == "wagner" )
+	{
+		view = proj_ptr( new projection::wagner() );
+		parallel = 0;
+	}
+	else if ( mapType == "winkel" )
+		view = proj_ptr( new projection::winkel( DEG2RAD( parallel ) ) );
+	else
+	{
+		view = proj_ptr( new projection::equirectangular( DEG2RAD( parallel ) ) );
+		mapType = "equirect";
+	}
+	
+	return view;
+}
+
+// Seeds from a list of seeds and inclusive ranges such as 1,5,10-20. A
+// seed listed twice is only kept the first time, since both copies would
+// write the same files at once.
+static bool parseSeeds( const std::string &list, std::vector<unsigned long> &seeds )
+{
+	std::stringstream items( list );
+	std::string item;
+	std::unordered_set<unsigned long> seen;
+	
+	// Streams read "-1" as a huge unsigned number, so each number has to
+	// start with a digit.
+	auto number = []( std::istream &in, unsigned long &value )
+	{
+		return std::isdigit( ( in >> std::ws ).peek() ) && in >> value;
+	};
+	
+	while ( std::getline( items, item, ',' ) )
+	{
+		std::stringstream range( item );
+		unsigned long first, last;
+		char dash;
+		
+		if ( !number( range, first ) )
+			return false;
+			
+		if ( range >> dash )
+		{
+			if ( dash != '-' || !number( range, last ) || last < first )
+				return false;
+		}
+		else
+			last = first;
+			
+		if ( !( range >> std::ws ).eof() )
+			return false;
+			
+		for ( unsigned long seed = first; ; ++seed )
+		{
+			if ( seen.insert( seed ).second )
+				seeds.push_back( seed );
+				
+			if ( seed == last )
+				break;
+		}
+	}
+	
+	return !seeds.empty();
+}
+
+// Draws a field of the grid onto a map and saves it.
+static void plotField( zw::plotter::gs &map, const zw::projection::base &view,
+                       const zw::geoData::geo_ptr &geodesic, const zw::real_t *field, const zw::cell_size_t cells,
+                       const zw::range_t range, const std::string &name )
+{
+	map.clear();
+	map.inputRange( range );
+	
+	for ( zw::cell_size_t c = 0; c < cells; ++c )
+		if ( view.valid( zw::coord( geodesic[c].v ) ) )
+			map.plot( view.convert( geodesic[c].v ), field[c] );
+			
+	view.drawBorder( map );
+	map.fill();
+	view.drawGraticule( map );
+	map.write( name );
+}
+
 int main( int argc, const char *argv[] )
 {
 	using namespace zw;
@@ -67,16 +561,46 @@ int main( int argc, const char *argv[] )
 	// World Creation Parameters
 	opt.add( "", 0, 1, 0, "[KM] Radius of Sphere", "-R", "--radius" );
 	opt.add( "", 0, 1, 0, "[%] Ocean Coverage", "-H", "--hydro" );
+	opt.add( "", 0, 1, 0, "[FILE] Hypsometric Profile", "--profile" );
+	opt.add( "", 0, 1, 0, "[%] Preview Ocean Coverage Without Rescaling",
+	         "--flood" );
+	opt.add( "", 0, 1, 0, "[KM] Report Cells Below A Sea Level", "--flood-level" );
+	opt.add( "", 0, 0, 0, "Estimate Elevations From A Quantile Sketch", "--sketch" );
+	opt.add( "", 0, 0, 0, "Report Landmasses And Oceans At Each Coverage",
+	         "--components" );
+	opt.add( "", 0, 0, 0, "Save Per-Region Statistics As CSV", "--regions" );
+	opt.add( "", 0, 1, 0, "[#] Worker Threads\n  default: one per core", "--threads" );
+	opt.add( "", 0, 1, 0, "[DIR] Reuse Noise Layers Saved In Directory", "--cache" );
 	
 	// Perlin Terrain Generation
 	opt.add( "", 0, 0, 0, "Use 3D Fractal Perlin Noise", "-n", "--noise" );
 	opt.add( "", 0, 0, 0, "Use 3D Fractal Ridged Noise", "-r", "--ridge" );
+	opt.add( "", 0, 1, 0, "[#] Raise And Lower Across Random Fault Planes\n"
+	         "  suggested: [1000 - 10000]", "-p", "--perturb" );
 	opt.add( "", 0, 1, 0, "[#] Noise Seed", "--seed" );
+	opt.add( "", 0, 1, 0, "[LIST] Create A World Per Seed, Named WORLD-SEED\n"
+	         "  example: 1,5,10-20", "--seeds" );
 	opt.add( "", 0, 1, 0, "[#] Noise Peristence\n  suggested: (0.0 - 1.0)",
 	         "--persist" );
 	opt.add( "", 0, 1, 0, "[#] Noise Lacunarity\n  suggested: [1.5 - 3.5]",
 	         "--lacuna" );
 	opt.add( "", 0, 1, 0, "[#] Noise Octaves\n  suggested: [1 - 16]", "--octave" );
+	opt.add( "", 0, 0, 0, "Keep Octaves Finer Than The Grid", "--all-octaves" );
+	opt.add( "perlin", 0, 1, 0, "[STRING] Noise Basis\n  "
+	         "perlin          - Classic Perlin\n  "
+	         "simplex         - Simplex", "--basis" );
+	opt.add( "double", 0, 1, 0, "[STRING] Noise Precision\n  "
+	         "double          - Reference, matches earlier versions\n  "
+	         "float           - Twice the vector width", "--precision" );
+	opt.add( "cosine", 0, 1, 0, "[STRING] Noise Interpolation\n  "
+	         "cosine          - Exact, the reference\n  "
+	         "polynomial      - Sine series, within 2e-6\n  "
+	         "table           - Lookup table, within 1e-5", "--interp" );
+	opt.add( "", 0, 0, 0, "Compare Noise Interpolation Against Cosine", "--interp-diff" );
+	opt.add( "", 0, 0, 0, "Find Noise Slopes From Analytic Gradients", "--slope" );
+	opt.add( "", 0, 0, 0, "Compare Batch Noise Kernels Against Point Sums", "--kernel-check" );
+	opt.add( "", 0, 1, 0, "[#] Evaluate Low fBm Octaves On Coarser Levels Within Tolerance\n"
+	         "  suggested: [0.01 - 0.1]", "--multigrid" );
 	
 	// Mapping Options
 	opt.add( "", 0, 1, 0, "[STRING] Map -> Projection\n  "
@@ -197,6 +721,29 @@ int main( int argc, const char *argv[] )
 		assert( hydro >= 0 && hydro <= 1.0 );
 	}
 	
+	real_t flood = -1;
+	
+	if ( opt.isSet( "--flood" ) )
+	{
+		opt.get( "--flood" )->getFloat( flood );
+		flood *= 0.01;
+		assert( flood >= 0 && flood < 1.0 );
+	}
+	
+	profile shape = profile::terran();
+	
+	if ( opt.isSet( "--profile" ) )
+	{
+		std::string profileFile;
+		opt.get( "--profile" )->getString( profileFile );
+		
+		if ( !shape.load( profileFile ) )
+		{
+			std::cerr << "Failed to load profile " << profileFile << std::endl;
+			return 1;
+		}
+	}
+	
 	//
 	// Perlin Noise Terrain Generation
 	//
@@ -220,6 +767,14 @@ int main( int argc, const char *argv[] )
 		useRidged = true;
 	}
 	
+	unsigned long faults = 0;
+	
+	if ( opt.isSet( "-p" ) )
+	{
+		opt.get( "-p" )->getULong( faults );
+		generateTerrain = generateTerrain || faults > 0;
+	}
+	
 	if ( opt.isSet( "--lacuna" ) )
 		opt.get( "--lacuna" )->getDouble( lacunarity );
 		
@@ -229,37 +784,132 @@ int main( int argc, const char *argv[] )
 	if ( opt.isSet( "--octave" ) )
 		opt.get( "--octave" )->getInt( octaves );
 		
-	assert( lacunarity > 1.0 );
-	assert( persistence > 0.0 && persistence < 1.0 );
-	assert( octaves > 0 );
-	
-	std::random_device seedGen;
-	unsigned long seed = seedGen();
+	std::string basis = "perlin";
 	
-	if ( opt.isSet( "--seed" ) )
+	if ( opt.isSet( "--basis" ) )
+		opt.get( "--basis" )->getString( basis );
+		
+	if ( basis != "perlin" && basis != "simplex" )
 	{
-		unsigned long userSeed;
-		opt.get( "--seed" )->getULong( userSeed );
+		std::cerr << "Unknown noise basis " << basis << std::endl;
+		return 1;
+	}
+	
+	std::string precision = "double";
+	
+	if ( opt.isSet( "--precision" ) )
+		opt.get( "--precision" )->getString( precision );
+		
+	if ( precision != "double" && precision != "float" )
+	{
+		std::cerr << "Unknown noise precision " << precision << std::endl;
+		return 1;
+	}
+	
+	std::string interp = "cosine";
+	noise::Blend blend = noise::Blend::cosine;
+	bool interpDiff = opt.isSet( "--interp-diff" );
+	double tolerance = 0;
+	
+	if ( opt.isSet( "--multigrid" ) )
+		opt.get( "--multigrid" )->getDouble( tolerance );
+		
+	assert( tolerance >= 0 );
+	
+	if ( opt.isSet( "--interp" ) )
+		opt.get( "--interp" )->getString( interp );
+		
+	if ( interp == "polynomial" )
+		blend = noise::Blend::polynomial;
+	else if ( interp == "table" )
+		blend = noise::Blend::table;
+	else if ( interp != "cosine" )
+	{
+		std::cerr << "Unknown noise interpolation " << interp << std::endl;
+		return 1;
+	}
+	
+	assert( lacunarity > 1.0 );
+	assert( persistence > 0.0 && persistence < 1.0 );
+	assert( octaves > 0 );
+	
+	std::random_device seedGen;
+	unsigned long seed = seedGen();
+	
+	if ( opt.isSet( "--seed" ) )
+	{
+		unsigned long userSeed;
+		opt.get( "--seed" )->getULong( userSeed );
 		seed = userSeed;
 	}
 	
-	std::cout << "using seed " << seed << std::endl;
-	std::mt19937_64 rng( seed );
+	std::vector<unsigned long> seeds;
+	
+	if ( opt.isSet( "--seeds" ) )
+	{
+		std::string list;
+		opt.get( "--seeds" )->getString( list );
+		
+		if ( !parseSeeds( list, seeds ) )
+		{
+			std::cerr << "Invalid seed list " << list << std::endl;
+			return 1;
+		}
+		
+		if ( !generateTerrain )
+		{
+			std::cerr << "A seed batch needs terrain, add -n, -r or -p" << std::endl;
+			return 1;
+		}
+		
+		// Each world of a batch is only surveyed, saved and mapped.
+		
+		for ( auto option : {"--slope", "--interp-diff", "--kernel-check", "--components", "--regions",
+		                     "--flood", "--flood-level"} )
+			if ( opt.isSet( option ) )
+			{
+				std::cerr << option << " can't be used with --seeds" << std::endl;
+				return 1;
+			}
+	}
+	
+	if ( opt.isSet( "--threads" ) )
+	{
+		int count;
+		opt.get( "--threads" )->getInt( count );
+		assert( count > 0 );
+		parallel::threads( count );
+	}
+	
+	std::string cacheDir;
+	
+	if ( opt.isSet( "--cache" ) )
+		opt.get( "--cache" )->getString( cacheDir );
+		
+	if ( seeds.empty() )
+		std::cout << "using seed " << seed << std::endl;
+	else
+		std::cout << "using " << seeds.size() << " seeds" << std::endl;
+		
 	
 	//
 	// Allocate Memory
 	//
 	
 	auto cells = cellsPerIteration( iterations );
-	std::unique_ptr<geoData[]> geodesic;
+	geoData::geo_ptr geodesic;
+	geoData::field_ptr elevation, base;
+	real_t floodedTo = 0;
 	
 	try
 	{
-		geodesic = std::unique_ptr<geoData[]>( new geoData[cells] );
+		geodesic = geoData::geo_ptr( new geoData[cells] );
+		elevation = geoData::field_ptr( new real_t[cells] );
 	}
 	catch ( std::bad_alloc &err )
 	{
-		std::cerr << "Failed to allocate " << ( sizeof( geoData )*cells ) <<
+		std::cerr << "Failed to allocate " << ( ( sizeof( geoData ) + 2 * sizeof(
+		              real_t ) ) * cells ) <<
 		          " bytes for geodesic.\nTry a smaller subdivision count.\n" << std::endl;
 		throw;
 	}
@@ -277,7 +927,7 @@ int main( int argc, const char *argv[] )
 		std::stringstream fileIn;
 		fileIn << nameIn << "_" << iterations << ".dat";
 		
-		if ( geoData::load( geodesic, cells, fileIn.str() ) )
+		if ( geoData::load( geodesic, elevation, base, floodedTo, cells, fileIn.str() ) )
 		{
 			std::cout << "loaded geodesic " << fileIn.str() << std::endl;
 			pass = iterations;
@@ -289,10 +939,30 @@ int main( int argc, const char *argv[] )
 	{
 		geoData::icosahedron( geodesic, generated );
 		std::cout << "loaded icosahedron" << std::endl;
+		
+		for ( cell_size_t c = 0; c < cells; ++c )
+			elevation[c] = 1.0;
+			
 		save = true;
 		++pass;
 	}
 	
+	// Older worlds don't keep a base heightmap, so start one from what they
+	// have now.
+	
+	bool layered = bool( base );
+	
+	if ( !layered )
+	{
+		base = geoData::field_ptr( new real_t[cells] );
+		std::copy( elevation.get(), elevation.get() + cells, base.get() );
+	}
+	
+	// The survey can only use a sketch taken while applying terrain if no
+	// rescale starts over from the base heightmap afterwards.
+	
+	const bool sketching = opt.isSet( "--sketch" ) && !( layered && ( hydro > 0 || radius > 0 ) );
+	
 	//
 	// Create Geodesic If Needed
 	//
@@ -310,86 +980,305 @@ int main( int argc, const char *argv[] )
 	// Perlin Noise
 	//
 	
-	if ( generateTerrain == true )
+	// Octaves finer than the grid add nothing but aliasing, so they're
+	// left out unless asked for.
+	
+	const int resolved = opt.isSet( "--all-octaves" ) ? std::numeric_limits<int>::max() :
+	                     resolvedOctaves( lacunarity, iterations );
+	                     
+	auto terrain = makeTerrain<noise::Perlin<double>>;
+	
+	if ( basis == "simplex" )
+		terrain = precision == "float" ? makeTerrain<noise::Simplex<float>> :
+		          makeTerrain<noise::Simplex<double>>;
+	else if ( precision == "float" )
+		terrain = makeTerrain<noise::Perlin<float>>;
+		
+	// The layer depends only on the noise settings and the grid, so a
+	// cached one can stand in for the whole noise stage.
+	
+	auto noiseLayer = [&]( const unsigned long noiseSeed, std::vector<double> &layer,
+	                       std::vector<double> *slope, std::ostream &log )
+	{
+		cache layers( cacheDir );
+		
+		if ( !cacheDir.empty() )
+		{
+			layers.key( std::string( noise::kernels() ) );
+			layers.key( basis );
+			layers.key( precision );
+			layers.key( interp );
+			layers.key( noiseSeed );
+			layers.key( octaves );
+			layers.key( resolved );
+			layers.key( lacunarity );
+			layers.key( persistence );
+			layers.key( usePerlin );
+			layers.key( useRidged );
+			layers.key( iterations );
+			layers.key( tolerance );
+			
+			if ( !slope && layers.load( layer ) )
+			{
+				log << "  loaded layer " << layers.file() << std::endl;
+				return;
+			}
+		}
+		
+		auto levels = terrain( octaves, resolved, lacunarity, noiseSeed, blend, usePerlin, useRidged,
+		                       persistence, tolerance, geodesic, iterations, layer, slope );
+		                       
+		if ( !levels.empty() )
+		{
+			log << "  multigrid levels =";
+			
+			for ( auto level : levels )
+				log << " " << level;
+				
+			log << std::endl;
+		}
+		
+		if ( !cacheDir.empty() )
+		{
+			if ( layers.save( layer ) )
+				log << "  saved layer " << layers.file() << std::endl;
+			else
+				std::cerr << "Failed to save layer " << layers.file() << std::endl;
+		}
+	};
+	
+	// Fault planes as a layer, the factor each cell of a heightmap moves
+	// by, so they apply to the elevation and base heightmaps alike. The
+	// planes run on the heightmap from before any rescaling.
+	
+	auto faultLayer = [&]( const unsigned long faultSeed, const geoData::field_ptr &from,
+	                       std::vector<double> &layer )
+	{
+		geoData::field_ptr moved( new real_t[cells] );
+		std::copy( from.get(), from.get() + cells, moved.get() );
+		geoData::perturb( geodesic, moved, cells, counterRng( faultSeed ), 0, faults );
+		
+		for ( cell_size_t c = 0; c < cells; ++c )
+			layer[c] = double( moved[c] ) / from[c];
+	};
+	
+	if ( usePerlin || useRidged )
 	{
 		std::cout << "generating noise" << std::endl;
 		std::cout << "  octaves = " << octaves << std::endl;
 		
+		if ( octaves > resolved )
+			std::cout << "  skipped octaves = " << octaves - resolved
+			          << ", finer than the grid" << std::endl;
+			          
 		if ( usePerlin )
 			std::cout << "  persistence = " << persistence << std::endl;
 			
 		std::cout << "  lacunarity = " << lacunarity << std::endl;
-		std::cout << "  seed = " << seed << std::endl;
-		
-		noise::PerlinOctave perlin( octaves, lacunarity, seed );
-		noise::PerlinOctave fractl( 6.0, lacunarity, seed * 1.5 );
 		
-		for ( cell_size_t c = 0; c < cells; ++c )
-		{
-			double result = 0;
-			double trench = 0;
-			double ridges = 0;
-			
-			if ( usePerlin )
-				result = perlin.noise( geodesic[c].v.x, geodesic[c].v.y, geodesic[c].v.z,
-				                       persistence );
-				                       
-			if ( useRidged )
-			{
-				trench = perlin.ridge( geodesic[c].v.x, geodesic[c].v.y, geodesic[c].v.z );
-				ridges = fractl.ridge( geodesic[c].v.x, geodesic[c].v.y, geodesic[c].v.z );
-				
-				if ( result > 0.75 ) result = ( result - 0.75 ) * 0.5 + 0.75;
-				
-				if ( result < -0.75 ) result = ( result + 0.75 ) * 0.5 - 0.75;
-			}
+		if ( seeds.empty() )
+			std::cout << "  seed = " << seed << std::endl;
 			
-			if ( ridges > 0.25 ) result += ( ridges - 0.25 ) * 4.0 / 3.0;
+		std::cout << "  basis = " << basis << std::endl;
+		std::cout << "  precision = " << precision << std::endl;
+		std::cout << "  interpolation = " << interp << std::endl;
+		
+		if ( tolerance > 0 && useRidged )
+			std::cout << "  multigrid skipped, ridges need every octave at every cell" << std::endl;
+		else if ( tolerance > 0 && usePerlin )
+			std::cout << "  multigrid tolerance = " << tolerance << std::endl;
 			
-			if ( trench > 0.25 ) result -= ( trench - 0.25 ) * 4.0 / 3.0;
+		if ( opt.isSet( "--kernel-check" ) )
+		{
+			auto check = checkKernels<noise::Perlin<double>>;
 			
-			result = result * 0.2 + 1.0;
-			geodesic[c].v *= result;
+			if ( basis == "simplex" )
+				check = precision == "float" ? checkKernels<noise::Simplex<float>> :
+				        checkKernels<noise::Simplex<double>>;
+			else if ( precision == "float" )
+				check = checkKernels<noise::Perlin<float>>;
+				
+			check( octaves, resolved, lacunarity, seed, blend, persistence, geodesic, iterations,
+			       std::cout );
 		}
-		
-		save = true;
 	}
 	
 	//
-	// Elevations
+	// Seed Batch
 	//
 	
-	std::cout << "calculating elevations" << std::endl;
+	if ( !seeds.empty() )
+	{
+		auto view = makeView( mapType, parallel );
+		view->meridian( DEG2RAD( meridian ) );
+		std::mutex report;
+		
+		// Seeds share the grid and get elevations of their own. With at
+		// least one seed per thread, each seed runs on a thread of its own,
+		// so the serial survey, saving and drawing overlap too.
+		
+		parallel::tasks( seeds.size(), [&]( std::size_t task )
+		{
+			std::stringstream slug, log;
+			slug << nameOut << "-" << seeds[task];
+			log << "world " << slug.str() << std::endl;
+			
+			geoData::field_ptr world( new real_t[cells] ), floor( new real_t[cells] );
+			std::copy( elevation.get(), elevation.get() + cells, world.get() );
+			std::copy( base.get(), base.get() + cells, floor.get() );
+			
+			std::vector<double> layer( cells );
+			sketch heights;
+			
+			if ( usePerlin || useRidged )
+			{
+				noiseLayer( seeds[task], layer, nullptr, log );
+				heights = applyTerrain( layer, world, floor, cells, sketching );
+			}
+			
+			if ( faults > 0 )
+			{
+				faultLayer( seeds[task], floor, layer );
+				heights = applyTerrain( layer, world, floor, cells, sketching );
+			}
+			
+			real_t shore;
+			range_t range = elevations( world, floor, heights, cells, layered, hydro, radius, shape,
+			                            opt.isSet( "--sketch" ), shore, log );
+			                            
+			std::stringstream fileOut, indexOut;
+			fileOut << slug.str() << "_" << iterations << ".dat";
+			indexOut << slug.str() << "_" << iterations << ".idx";
+			log << "saving geodesic " << fileOut.str() << std::endl;
+			geoData::save( geodesic, world, floor, hydro > 0 ? shore : radius > 0 ? 0 : floodedTo, cells,
+			               fileOut.str() );
+			log << "saving index " << indexOut.str() << std::endl;
+			ranking( world.get(), cells ).save( indexOut.str() );
+			
+			if ( genMap && range.first < range.second )
+			{
+				plotter::gs map( view->aspect(), 768, 512 );
+				std::string name = getMapFile( slug.str(), "height", mapType, iterations, parallel,
+				                               meridian );
+				log << "saving map " << name << std::endl;
+				plotField( map, *view, geodesic, world.get(), cells, range, name );
+			}
+			
+			std::lock_guard<std::mutex> lock( report );
+			std::cout << log.str();
+		} );
+		
+		return 0;
+	}
 	
-	real_t seaLevel = geoData::findElevation( geodesic, cells, hydro );
+	sketch heights;
+	geoData::field_ptr interpError, slopes;
+	real_t interpWorst = 0;
+	real_t steepest = 0;
 	
-	if ( radius > 0 )
+	if ( usePerlin || useRidged )
 	{
-		for ( cell_size_t c = 0; c < cells; ++c )
+		auto started = std::chrono::steady_clock::now();
+		std::vector<double> layer( cells ), slope;
+		
+		if ( opt.isSet( "--slope" ) )
+			slope.resize( cells );
+			
+		noiseLayer( seed, layer, slope.empty() ? nullptr : &slope, std::cout );
+		
+		// Slope of the noise factor per radian along the surface.
+		if ( !slope.empty() )
 		{
-			real_t multiplier = ( geodesic[c].v.magnitude() / seaLevel ) * radius;
-			geodesic[c].v = geodesic[c].v.normalize() * multiplier;
+			slopes = geoData::field_ptr( new real_t[cells] );
+			
+			for ( cell_size_t c = 0; c < cells; ++c )
+			{
+				slopes[c] = slope[c];
+				steepest = std::max( steepest, slopes[c] );
+			}
+			
+			std::cout << "  steepest slope = " << steepest << std::endl;
 		}
 		
-		save = true;
+		if ( interpDiff )
+		{
+			interpError = geoData::field_ptr( new real_t[cells] );
+			std::copy( elevation.get(), elevation.get() + cells, interpError.get() );
+		}
+		
+		heights = applyTerrain( layer, elevation, base, cells, sketching );
+		
+		std::cout << "  took " << std::chrono::duration<double>(
+		              std::chrono::steady_clock::now() - started ).count() << " s" << std::endl;
+		              
+		// Run the noise again with cosine weights and measure the change in
+		// grey levels of a height map. Under one level, maps can't tell the
+		// two apart.
+		
+		if ( interpDiff )
+		{
+			terrain( octaves, resolved, lacunarity, seed, noise::Blend::cosine, usePerlin, useRidged,
+			         persistence, tolerance, geodesic, iterations, layer, nullptr );
+			         
+			for ( cell_size_t c = 0; c < cells; ++c )
+				interpError[c] *= layer[c];
+				
+			range_t range = geoData::extremes( interpError, cells );
+			
+			for ( cell_size_t c = 0; c < cells; ++c )
+			{
+				interpError[c] = std::abs( elevation[c] - interpError[c] );
+				interpWorst = std::max( interpWorst, interpError[c] );
+			}
+			
+			real_t levels = range.second > range.first ?
+			                interpWorst / ( range.second - range.first ) * 256 : 0;
+			std::cout << "  differs from cosine by up to " << interpWorst << " ("
+			          << levels << " grey levels)" << std::endl;
+			          
+			if ( levels >= 1 )
+			{
+				std::cerr << "Interpolation " << interp << " changes the height map visibly"
+				          << std::endl;
+				return 1;
+			}
+		}
 	}
 	
-	range_t extremes = geoData::extremes( geodesic, cells );
-	seaLevel = geoData::findElevation( geodesic, cells, hydro, extremes );
+	if ( faults > 0 )
+	{
+		std::cout << "perturbing " << faults << " fault planes" << std::endl;
+		auto started = std::chrono::steady_clock::now();
+		std::vector<double> layer( cells );
+		faultLayer( seed, base, layer );
+		heights = applyTerrain( layer, elevation, base, cells, sketching );
+		
+		std::cout << "  took " << std::chrono::duration<double>(
+		              std::chrono::steady_clock::now() - started ).count() << " s" << std::endl;
+	}
+	
+	if ( generateTerrain == true )
+		save = true;
+		
+	//
+	// Elevations
+	//
+	
+	std::cout << "calculating elevations" << std::endl;
+	
+	real_t seaLevel;
+	range_t extremes = elevations( elevation, base, heights, cells, layered, hydro, radius, shape,
+	                               opt.isSet( "--sketch" ), seaLevel, std::cout );
+	                               
+	// A rescale starts over from the base heightmap, so it keeps no sea but
+	// its own.
 	
 	if ( hydro > 0 || radius > 0 )
 	{
-		extremes = geoData::rescale( geodesic, cells, seaLevel, hydro, extremes );
+		floodedTo = hydro > 0 ? seaLevel : 0;
 		save = true;
 	}
 	
-	std::cout << "  high point: " << extremes.second << " km" << std::endl;
-	
-	if ( hydro > 0 && seaLevel > extremes.first )
-		std::cout << "  sea level:  " << seaLevel << " km" << std::endl;
-		
-	std::cout << "  low point:  " << extremes.first << " km" << std::endl;
-	
 	//
 	// Output Geodesic
 	//
@@ -399,113 +1288,113 @@ int main( int argc, const char *argv[] )
 		std::stringstream fileOut;
 		fileOut << nameOut << "_" << iterations << ".dat";
 		std::cout << "saving geodesic " << fileOut.str() << std::endl;
-		geoData::save( geodesic, cells, fileOut.str() );
+		geoData::save( geodesic, elevation, base, floodedTo, cells, fileOut.str() );
 	}
 	
 	//
-	// Cylindrical Projections
+	// Elevation Index
 	//
 	
-	if ( mapType == "behrmann" )
+	ranking index;
+	std::stringstream indexFile;
+	indexFile << nameOut << "_" << iterations << ".idx";
+	
+	if ( !save && index.load( indexFile.str(), elevation.get(), cells ) )
+		std::cout << "loaded index " << indexFile.str() << std::endl;
+	else
 	{
-		mapType = "cea";
-		parallel = 30.0;
+		index = ranking( elevation.get(), cells );
+		std::cout << "saving index " << indexFile.str() << std::endl;
+		index.save( indexFile.str() );
 	}
-	else if ( mapType == "gall-peters" )
-	{
-		mapType = "cea";
-		parallel = 45.0;
-	}
-	else if ( mapType == "hobo-dyer" )
+	
+	real_t shoreLevel = seaLevel;
+	
+	if ( flood >= 0 )
 	{
-		mapType = "cea";
-		parallel = 37.5;
+		shoreLevel = index.seaLevel( flood );
+		std::cout << "  flooded to " << flood * 100 << "%: " << shoreLevel << " km" <<
+		          std::endl;
 	}
-	else if ( mapType == "lambert" )
+	
+	if ( opt.isSet( "--flood-level" ) )
 	{
-		mapType = "cea";
-		parallel = 0;
+		real_t level;
+		opt.get( "--flood-level" )->getFloat( level );
+		cell_size_t below = index.flooded( level );
+		std::cout << "  below " << level << " km: " << below << " cells (" <<
+		          100.0 * below / cells << "%)" << std::endl;
 	}
 	
 	//
-	// Equirectangular Projections
+	// Connected Components
 	//
 	
-	if ( mapType == "plate-carree" )
+	if ( opt.isSet( "--components" ) )
 	{
-		mapType = "equirect";
-		parallel = 0;
+		std::cout << "finding landmasses and oceans" << std::endl;
+		components land( geodesic, index, true );
+		components ocean( geodesic, index, false );
+		
+		// Share of the whole grid held by the largest component.
+		auto largest = []( const std::vector<cell_size_t> &sizes, cell_size_t total )
+		{
+			return sizes.empty() ? 0.0 : 100.0 * sizes.front() / total;
+		};
+		
+		std::cout << "  coverage  landmasses  largest  oceans  largest" << std::endl;
+		
+		for ( int percent = 5; percent < 100; percent += 5 )
+		{
+			real_t level = index.seaLevel( percent * 0.01 );
+			auto landmasses = land.at( level );
+			auto oceans = ocean.at( level );
+			
+			std::cout << std::setw( 9 ) << percent << "%" << std::setw( 12 ) <<
+			          landmasses.size() << std::setw( 8 ) << std::fixed << std::setprecision(
+			              1 ) << largest( landmasses, cells ) << "%" << std::setw( 8 ) <<
+			          oceans.size() << std::setw( 8 ) << largest( oceans,
+			                  cells ) << "%" << std::defaultfloat << std::endl;
+		}
 	}
 	
 	//
-	// Create Map Projections
+	// Region Statistics
 	//
 	
-	using proj_ptr = std::unique_ptr<projection::base>;
-	proj_ptr view;
-	
-	if ( mapType == "aitoff" )
-	{
-		view = proj_ptr( new projection::aitoff() );
-		parallel = 0;
-	}
-	else if ( mapType == "braun" )
-	{
-		view = proj_ptr( new projection::stereographic( 1 ) );
-		parallel = 0;
-	}
-	else if ( mapType == "cea" )
-		view = proj_ptr( new projection::equalarea( DEG2RAD( parallel ) ) );
-	else if ( mapType == "gall" )
-	{
-		view = proj_ptr( new projection::stereographic( 2 ) );
-		parallel = 0;
-	}
-	else if ( mapType == "hammer" )
-	{
-		view = proj_ptr( new projection::hammer() );
-		parallel = 0;
-	}
-	else if ( mapType == "kavrayskiy" )
-	{
-		view = proj_ptr( new projection::kavrayskiy() );
-		parallel = 0;
-	}
-	else if ( mapType == "mercator" )
-	{
-		view = proj_ptr( new projection::mercator() );
-		parallel = 0;
-	}
-	else if ( mapType == "miller" )
-	{
-		view = proj_ptr( new projection::miller() );
-		parallel = 0;
-	}
-	else if ( mapType == "ortelius" )
+	if ( opt.isSet( "--regions" ) )
 	{
-		view = proj_ptr( new projection::ortelius() );
-		parallel = 0;
-	}
-	else if ( mapType == "orthographic" )
-		view = proj_ptr( new projection::orthographic( DEG2RAD( parallel ) ) );
-	else if ( mapType == "sinusoidal" )
-	{
-		view = proj_ptr( new projection::sinusoidal() );
-		parallel = 0;
-	}
-	else if ( mapType == "wagner" )
-	{
-		view = proj_ptr( new projection::wagner() );
-		parallel = 0;
-	}
-	else if ( mapType == "winkel" )
-		view = proj_ptr( new projection::winkel( DEG2RAD( parallel ) ) );
-	else
-	{
-		view = proj_ptr( new projection::equirectangular( DEG2RAD( parallel ) ) );
-		mapType = "equirect";
+		std::stringstream fileOut;
+		fileOut << nameOut << "_" << iterations << "_regions.csv";
+		std::cout << "saving regions " << fileOut.str() << std::endl;
+		
+		// The shore is the one asked for, or else the sea the world was last
+		// flooded to. Dry worlds are all land.
+		real_t shore = flood >= 0 ? shoreLevel : floodedTo > 0 ? floodedTo : extremes.first;
+		regions summary( geodesic, elevation, cells, shore, seaLevel );
+		
+		if ( !summary.save( fileOut.str() ) )
+		{
+			std::cerr << "Failed to save " << fileOut.str() << std::endl;
+			return 1;
+		}
+		
+		double land = 0, area = 0;
+		
+		for ( std::size_t r = 0; r < summary.size(); ++r )
+		{
+			land += summary[r].land * summary[r].area;
+			area += summary[r].area;
+		}
+		
+		std::cout << "  land: " << 100 * land / area << "% of the surface" << std::endl;
 	}
 	
+	//
+	// Create Map Projections
+	//
+	
+	auto view = makeView( mapType, parallel );
 	view->meridian( DEG2RAD( meridian ) );
 	
 	//
@@ -538,35 +1427,53 @@ int main( int argc, const char *argv[] )
 		std::string name = getMapFile( nameOut, "height", mapType, iterations, parallel,
 		                               meridian );
 		std::cout << "saving map " << name << std::endl;
-		map.clear();
-		map.inputRange( extremes );
-		
-		for ( cell_size_t c = 0; c < cells; ++c )
-			if ( view->valid( coord( geodesic[c].v ) ) )
-				map.plot( view->convert( geodesic[c].v ), geodesic[c].v.magnitude() );
-				
-		view->drawBorder( map );
-		map.fill();
-		view->drawGraticule( map );
-		map.write( name );
+		plotField( map, *view, geodesic, elevation.get(), cells, extremes, name );
 	}
 	
-	if ( genMap  && hydro > 0 )
+	if ( genMap && interpWorst > 0 )
 	{
-		std::string name = getMapFile( nameOut, "land", mapType, iterations, parallel,
+		std::string name = getMapFile( nameOut, "interp", mapType, iterations, parallel,
 		                               meridian );
 		std::cout << "saving map " << name << std::endl;
+		plotField( map, *view, geodesic, interpError.get(), cells, range_t( 0, interpWorst ), name );
+	}
+	
+	if ( genMap && steepest > 0 )
+	{
+		std::string name = getMapFile( nameOut, "slope", mapType, iterations, parallel,
+		                               meridian );
+		std::cout << "saving map " << name << std::endl;
+		plotField( map, *view, geodesic, slopes.get(), cells, range_t( 0, steepest ), name );
+	}
+	
+	if ( genMap && ( hydro > 0 || flood >= 0 ) )
+	{
+		std::stringstream dataset;
+		dataset << "land";
+		
+		if ( flood >= 0 )
+			dataset << "-" << flood * 100;
+			
+		std::string name = getMapFile( nameOut, dataset.str(), mapType, iterations,
+		                               parallel, meridian );
+		std::cout << "saving map " << name << std::endl;
 		map.clear();
 		map.inputRange( extremes );
 		
-		for ( cell_size_t c = 0; c < cells; ++c )
+		// The index is in elevation order, so everything before the shore
+		// is under water.
+		
+		cell_size_t shore = index.flooded( shoreLevel );
+		
+		for ( cell_size_t r = 0; r < cells; ++r )
+		{
+			auto c = index.cell( r );
+			
 			if ( view->valid( coord( geodesic[c].v ) ) )
-			{
-				real_t magnitude = geodesic[c].v.magnitude();
 				map.plot( view->convert( geodesic[c].v ),
-				          magnitude < seaLevel ? extremes.first : magnitude );
-			}
-			
+				          r < shore ? extremes.first : index.value( r ) );
+		}
+		
 		view->drawBorder( map );
 		map.fill();
 		view->drawGraticule( map );